@@ -1,3 +1,8 @@
+// flightbooking_system.cpp
+// Flight booking system: core classes, search/sort algorithms, design patterns
+// Build: g++ -std=c++20 -O2 -pthread flightbooking_system.cpp -o flightbooking_system
+// (-std=c++17 also builds; it leaves out the coroutine booking workflow)
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -5,8 +10,54 @@
 #include <algorithm>
 #include <queue>
 #include <unordered_map>
+#include <unordered_set>
 #include <limits>
 #include <utility>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <string_view>
+#include <mutex>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <random>
+#include <iomanip>
+#include <array>
+#include <cmath>
+#include <future>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <tuple>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <new>
+#include <initializer_list>
+#ifdef __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <csignal>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <climits>
+#endif
 
 using namespace std;
 
@@ -17,481 +68,7700 @@ class Booking;
 enum class SeatClass;
 
 // ============================================================================
-// CORE CLASSES: Flight, Passenger, Booking System
+// BOOKING IDS: 64-bit, generated without locks
 // ============================================================================
 
-class Flight {
-protected:
-    string flightNumber;
-    string departureCity;
-    string arrivalCity;
-    string departureTime;
-    string arrivalTime;
-    int totalSeats;
-    int availableSeats;
+// Layout (most significant bit first):
+//   1 bit  unused (keeps IDs positive when stored as signed)
+//  41 bits milliseconds since ID_EPOCH_MS (~69 years)
+//  10 bits shard (one generator per shard / worker process)
+//  12 bits sequence within the millisecond
+using BookingId = uint64_t;
+
+class BookingIdGenerator {
+private:
+    static constexpr uint64_t ID_EPOCH_MS = 1735689600000ULL; // 2025-01-01 UTC
+    static constexpr int SHARD_BITS = 10;
+    static constexpr int SEQUENCE_BITS = 12;
+
+    // (timestamp << SEQUENCE_BITS) | sequence of the last ID handed out.
+    // A single CAS claims the next value; if the clock has not advanced
+    // (or has gone backwards) we simply take the next sequence number, and
+    // a sequence overflow just borrows from the following millisecond.
+    atomic<uint64_t> lastStamp;
+    uint64_t shard;
+
+    static uint64_t currentMillis() {
+        auto now = chrono::system_clock::now().time_since_epoch();
+        return chrono::duration_cast<chrono::milliseconds>(now).count() - ID_EPOCH_MS;
+    }
 
 public:
-    Flight(string fn, string dep, string arr, string depTime, string arrTime, int seats)
-        : flightNumber(fn), departureCity(dep), arrivalCity(arr),
-          departureTime(depTime), arrivalTime(arrTime), totalSeats(seats), availableSeats(seats) {}
+    explicit BookingIdGenerator(uint16_t shardId = 0)
+        : lastStamp(0), shard(shardId & ((1u << SHARD_BITS) - 1)) {}
 
-    virtual double getBasePrice() const = 0;
-    virtual string getFlightType() const = 0;
+    BookingId next() {
+        uint64_t last = lastStamp.load(memory_order_relaxed);
+        uint64_t stamp;
+        do {
+            stamp = max(currentMillis() << SEQUENCE_BITS, last + 1);
+        } while (!lastStamp.compare_exchange_weak(last, stamp, memory_order_relaxed));
 
-    bool bookSeat() {
-        if (availableSeats > 0) {
-            availableSeats--;
-            return true;
-        }
-        return false;
+        uint64_t millis = stamp >> SEQUENCE_BITS;
+        uint64_t sequence = stamp & ((1u << SEQUENCE_BITS) - 1);
+        return (millis << (SHARD_BITS + SEQUENCE_BITS)) | (shard << SEQUENCE_BITS) | sequence;
     }
 
-    void displayInfo() const {
-        cout << flightNumber << ": " << departureCity << " -> " << arrivalCity
-             << " (" << departureTime << " - " << arrivalTime << ")" << endl;
-        cout << "Available seats: " << availableSeats << "/" << totalSeats << endl;
+    static uint64_t timestampOf(BookingId id) { return (id >> (SHARD_BITS + SEQUENCE_BITS)) + ID_EPOCH_MS; }
+    static uint16_t shardOf(BookingId id) { return (id >> SEQUENCE_BITS) & ((1u << SHARD_BITS) - 1); }
+    static uint16_t sequenceOf(BookingId id) { return id & ((1u << SEQUENCE_BITS) - 1); }
+};
+
+// IDs are only turned into text for display and export: "BK" + base-36.
+string formatBookingId(BookingId id) {
+    static const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    char buf[16];
+    int pos = sizeof(buf);
+    do {
+        buf[--pos] = digits[id % 36];
+        id /= 36;
+    } while (id > 0);
+    return "BK" + string(buf + pos, sizeof(buf) - pos);
+}
+
+// ============================================================================
+// LATENCY HISTOGRAMS
+// ============================================================================
+
+// Log-linear histogram of nanosecond latencies: 8 linear sub-buckets per
+// power of two, i.e. about 12% resolution over the whole 64-bit range in
+// 4 KB, with O(1) record and merge.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+    array<uint64_t, BUCKETS> counts{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t maxValue = 0;
+
+public:
+    static int bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<int>(value);
+        int shift = (63 - __builtin_clzll(value)) - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
     }
 
-    // Getters for search operations
-    string getDepartureCity() const { return departureCity; }
-    string getArrivalCity() const { return arrivalCity; }
-    string getFlightNumber() const { return flightNumber; }
-    int getAvailableSeats() const { return availableSeats; }
+    // Largest value that falls into the bucket
+    static uint64_t bucketLimit(int bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = bucket / SUB_BUCKETS - 1;
+        uint64_t sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+    }
 
-    virtual ~Flight() = default;
+    void record(uint64_t nanos) {
+        counts[bucketOf(nanos)]++;
+        total++;
+        sum += nanos;
+        maxValue = max(maxValue, nanos);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < BUCKETS; b++) counts[b] += other.counts[b];
+        total += other.total;
+        sum += other.sum;
+        maxValue = max(maxValue, other.maxValue);
+    }
+
+    // Adds pre-bucketed counts (used when collecting per-thread metrics)
+    void addBucket(int bucket, uint64_t n) {
+        counts[bucket] += n;
+        total += n;
+    }
+
+    void addTotals(uint64_t nanos, uint64_t maxNanos) {
+        sum += nanos;
+        maxValue = max(maxValue, maxNanos);
+    }
+
+    void reset() { *this = LatencyHistogram(); }
+
+    // Upper edge of the bucket holding the p-th quantile (0 < p <= 1)
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * total);
+        if (rank >= total) rank = total - 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < BUCKETS; b++) {
+            seen += counts[b];
+            if (seen > rank) return min(bucketLimit(b), maxValue);
+        }
+        return maxValue;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t bucketCount(int bucket) const { return counts[bucket]; }
+    uint64_t totalNanos() const { return sum; }
+    uint64_t maxNanos() const { return maxValue; }
+    double mean() const { return total ? double(sum) / total : 0.0; }
 };
 
-class DomesticFlight : public Flight {
-public:
-    DomesticFlight(string fn, string dep, string arr, string depTime, string arrTime, int seats)
-        : Flight(fn, dep, arr, depTime, arrTime, seats) {}
+// ============================================================================
+// OPERATION METRICS (build with -DFBS_METRICS=0 to compile them out)
+// ============================================================================
 
-    double getBasePrice() const override { return 5000.0; }
-    string getFlightType() const override { return "Domestic"; }
+#ifndef FBS_METRICS
+#define FBS_METRICS 1
+#endif
+
+enum class MetricOp {
+    CreateBooking, ConfirmBooking, FindFlightByDestination, FindFlightsByPriceRange,
+    FindCheapestFlight, Query, SortFlightsByPrice, SortBookingsByPrice, FindCheapestRoute,
+    Count
 };
 
-class InternationalFlight : public Flight {
-public:
-    InternationalFlight(string fn, string dep, string arr, string depTime, string arrTime, int seats)
-        : Flight(fn, dep, arr, depTime, arrTime, seats) {}
+constexpr size_t METRIC_OP_COUNT = static_cast<size_t>(MetricOp::Count);
 
-    double getBasePrice() const override { return 25000.0; }
-    string getFlightType() const override { return "International"; }
+inline const char* metricOpName(MetricOp op) {
+    static const char* names[] = {
+        "createBooking", "confirmBooking", "findFlightByDestination", "findFlightsByPriceRange",
+        "findCheapestFlight", "query", "sortFlightsByPrice", "sortBookingsByPrice", "findCheapestRoute"};
+    return names[static_cast<size_t>(op)];
+}
+
+struct MetricsSnapshot {
+    array<LatencyHistogram, METRIC_OP_COUNT> latency;
+    array<uint64_t, METRIC_OP_COUNT> failures{};
+
+    void dump(ostream& out) const {
+        out << left << setw(26) << "operation" << right << setw(10) << "count" << setw(9) << "failed"
+            << setw(11) << "mean_ns" << setw(11) << "p50_ns" << setw(11) << "p99_ns" << setw(12) << "max_ns" << endl;
+        for (size_t i = 0; i < METRIC_OP_COUNT; i++) {
+            const LatencyHistogram& h = latency[i];
+            if (h.count() == 0 && failures[i] == 0) continue;
+            out << left << setw(26) << metricOpName(static_cast<MetricOp>(i)) << right << setw(10) << h.count()
+                << setw(9) << failures[i] << setw(11) << uint64_t(h.mean()) << setw(11) << h.percentile(0.50)
+                << setw(11) << h.percentile(0.99) << setw(12) << h.maxNanos() << endl;
+        }
+        out << left;
+    }
 };
 
-enum class SeatClass { Economy, Business, First };
+#if FBS_METRICS
 
-class Passenger {
+// Every thread records into its own slot with plain relaxed loads/stores
+// (single writer, no lock prefix). snapshot() sums all slots; reset() records
+// a baseline that later snapshots subtract, so writers are never disturbed.
+class OperationMetrics {
 private:
-    string name;
-    string passportNumber;
-    string contactNumber;
-    string email;
+    struct OpCounters {
+        array<atomic<uint64_t>, LatencyHistogram::BUCKETS> buckets{};
+        atomic<uint64_t> sum{0};
+        atomic<uint64_t> maxNanos{0};
+        atomic<uint64_t> failures{0};
+    };
+
+    struct ThreadSlot {
+        array<OpCounters, METRIC_OP_COUNT> ops;
+        bool inUse = true;
+    };
+
+    static void bump(atomic<uint64_t>& counter, uint64_t by) {
+        counter.store(counter.load(memory_order_relaxed) + by, memory_order_relaxed);
+    }
+
+    mutex registryMutex;                  // guards slots, only taken on thread start/exit
+    vector<unique_ptr<ThreadSlot>> slots; // slots outlive their threads so counts persist
+    MetricsSnapshot baseline;
+
+    // Registers the slot on first use and hands it back when the thread exits
+    struct SlotHandle {
+        ThreadSlot* slot;
+        SlotHandle() : slot(instance().acquireSlot()) {}
+        ~SlotHandle() { instance().releaseSlot(slot); }
+    };
+
+    ThreadSlot* acquireSlot() {
+        lock_guard<mutex> guard(registryMutex);
+        for (auto& slot : slots) {
+            if (!slot->inUse) { slot->inUse = true; return slot.get(); }
+        }
+        slots.push_back(make_unique<ThreadSlot>());
+        return slots.back().get();
+    }
+
+    void releaseSlot(ThreadSlot* slot) {
+        lock_guard<mutex> guard(registryMutex);
+        slot->inUse = false;
+    }
+
+    static ThreadSlot& local() {
+        thread_local SlotHandle handle;
+        return *handle.slot;
+    }
+
+    MetricsSnapshot collect() {
+        MetricsSnapshot total;
+        lock_guard<mutex> guard(registryMutex);
+        for (const auto& slot : slots) {
+            for (size_t i = 0; i < METRIC_OP_COUNT; i++) {
+                const OpCounters& c = slot->ops[i];
+                for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                    uint64_t n = c.buckets[b].load(memory_order_relaxed);
+                    if (n) total.latency[i].addBucket(b, n);
+                }
+                total.latency[i].addTotals(c.sum.load(memory_order_relaxed), c.maxNanos.load(memory_order_relaxed));
+                total.failures[i] += c.failures.load(memory_order_relaxed);
+            }
+        }
+        return total;
+    }
 
 public:
-    Passenger(string n, string pass, string contact, string mail)
-        : name(n), passportNumber(pass), contactNumber(contact), email(mail) {}
+    static OperationMetrics& instance() {
+        static OperationMetrics metrics;
+        return metrics;
+    }
 
-    string getName() const { return name; }
-    string getPassport() const { return passportNumber; }
-    string getContact() const { return contactNumber; }
-    string getEmail() const { return email; }
+    static void record(MetricOp op, uint64_t nanos) {
+        OpCounters& c = local().ops[static_cast<size_t>(op)];
+        bump(c.buckets[LatencyHistogram::bucketOf(nanos)], 1);
+        bump(c.sum, nanos);
+        if (nanos > c.maxNanos.load(memory_order_relaxed)) c.maxNanos.store(nanos, memory_order_relaxed);
+    }
 
-    void displayInfo() const {
-        cout << "Name: " << name << endl;
-        cout << "Passport: " << passportNumber << endl;
-        cout << "Contact: " << contactNumber << endl;
-        cout << "Email: " << email << endl;
+    static void recordFailure(MetricOp op) {
+        bump(local().ops[static_cast<size_t>(op)].failures, 1);
+    }
+
+    // Totals across all threads since the last reset (max is since start)
+    static MetricsSnapshot snapshot() {
+        OperationMetrics& m = instance();
+        MetricsSnapshot total = m.collect();
+        MetricsSnapshot result;
+        for (size_t i = 0; i < METRIC_OP_COUNT; i++) {
+            for (int b = 0; b < LatencyHistogram::BUCKETS; b++) {
+                uint64_t n = total.latency[i].bucketCount(b) - m.baseline.latency[i].bucketCount(b);
+                if (n) result.latency[i].addBucket(b, n);
+            }
+            result.latency[i].addTotals(total.latency[i].totalNanos() - m.baseline.latency[i].totalNanos(),
+                                        total.latency[i].maxNanos());
+            result.failures[i] = total.failures[i] - m.baseline.failures[i];
+        }
+        return result;
+    }
+
+    static void reset() {
+        OperationMetrics& m = instance();
+        m.baseline = m.collect();
     }
+
+    static void dump(ostream& out) { snapshot().dump(out); }
 };
 
-class Booking {
+// Times the enclosing scope into the calling thread's slot
+class ScopedOpTimer {
 private:
-    string bookingId;
-    shared_ptr<Flight> flight;
-    shared_ptr<Passenger> passenger;
-    SeatClass seatClass;
-    double totalPrice;
-    bool confirmed;
+    MetricOp op;
+    chrono::steady_clock::time_point start;
 
 public:
-    Booking(string id, shared_ptr<Flight> f, shared_ptr<Passenger> p, SeatClass sc)
-        : bookingId(id), flight(f), passenger(p), seatClass(sc), confirmed(false) {
-        calculatePrice();
+    explicit ScopedOpTimer(MetricOp o) : op(o), start(chrono::steady_clock::now()) {}
+    ~ScopedOpTimer() {
+        auto elapsed = chrono::steady_clock::now() - start;
+        OperationMetrics::record(op, chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
     }
+};
 
-    void calculatePrice() {
-        double basePrice = flight->getBasePrice();
-        double multiplier = 1.0;
-        switch (seatClass) {
-            case SeatClass::Economy: multiplier = 1.0; break;
-            case SeatClass::Business: multiplier = 2.5; break;
-            case SeatClass::First: multiplier = 4.0; break;
+#define FBS_METRIC_SCOPE(op) ScopedOpTimer fbsMetricTimer_(op)
+#define FBS_METRIC_FAILURE(op) OperationMetrics::recordFailure(op)
+
+#else
+
+// Metrics disabled: same API, nothing recorded
+class OperationMetrics {
+public:
+    static MetricsSnapshot snapshot() { return MetricsSnapshot(); }
+    static void reset() {}
+    static void dump(ostream& out) { out << "metrics disabled (built with FBS_METRICS=0)" << endl; }
+};
+
+#define FBS_METRIC_SCOPE(op) ((void)0)
+#define FBS_METRIC_FAILURE(op) ((void)0)
+
+#endif
+
+// ============================================================================
+// ALLOCATION COUNTER (build with -DFBS_ALLOC_TEST to count heap allocations)
+// ============================================================================
+
+// Test builds replace the global operator new so `alloctest` can check
+// that the create-and-confirm path stays allocation-free. Normal builds
+// keep the default allocator and report counting as unavailable.
+class AllocationCounter {
+private:
+    static atomic<uint64_t>& counter() {
+        static atomic<uint64_t> count{0};
+        return count;
+    }
+
+public:
+#ifdef FBS_ALLOC_TEST
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    static void note() { counter().fetch_add(1, memory_order_relaxed); }
+    static uint64_t count() { return counter().load(memory_order_relaxed); }
+};
+
+#ifdef FBS_ALLOC_TEST
+void* operator new(size_t size) {
+    AllocationCounter::note();
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+// ============================================================================
+// TIME: integer minutes since the schedule epoch
+// ============================================================================
+
+// Times are minutes since 2025-01-01 00:00 (local airport time is not
+// modelled). int32 covers several thousand years, compares in one
+// instruction and makes connection times a subtraction.
+using TimeMinutes = int32_t;
+
+constexpr TimeMinutes INVALID_TIME = numeric_limits<TimeMinutes>::min();
+constexpr TimeMinutes MINUTES_PER_DAY = 24 * 60;
+
+// Days since 1970-01-01 for a proleptic Gregorian date (H. Hinnant's algorithm)
+constexpr int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+constexpr int64_t SCHEDULE_EPOCH_DAY = daysFromCivil(2025, 1, 1);
+
+inline void civilFromDays(int64_t z, int& y, int& m, int& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    y = static_cast<int>(yoe + era * 400 + (m <= 2));
+}
+
+constexpr bool isLeapYear(int64_t y) { return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0); }
+
+constexpr int daysInMonth(int64_t y, int m) {
+    constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeapYear(y) ? 29 : days[m - 1];
+}
+
+inline TimeMinutes makeTime(int year, int month, int day, int hour = 0, int minute = 0) {
+    int64_t days = daysFromCivil(year, month, day) - SCHEDULE_EPOCH_DAY;
+    return static_cast<TimeMinutes>(days * MINUTES_PER_DAY + hour * 60 + minute);
+}
+
+inline TimeMinutes dayOf(TimeMinutes t) {
+    return t >= 0 ? t / MINUTES_PER_DAY : -((-t + MINUTES_PER_DAY - 1) / MINUTES_PER_DAY);
+}
+
+// Accepts "YYYY-MM-DD HH:MM" or "HH:MM"; a bare clock time falls on the day
+// of referenceDay (default: the epoch day). Returns INVALID_TIME if malformed.
+inline TimeMinutes parseTime(const string& text, TimeMinutes referenceDay = 0) {
+    int y, mo, d, h, mi;
+    char tail;
+    if (sscanf(text.c_str(), "%d-%d-%d %d:%d%c", &y, &mo, &d, &h, &mi, &tail) == 5) {
+        if (mo < 1 || mo > 12 || d < 1 || d > daysInMonth(y, mo) || h < 0 || h > 23 || mi < 0 || mi > 59) {
+            return INVALID_TIME;
         }
-        totalPrice = basePrice * multiplier;
+        int64_t minutes = (daysFromCivil(y, mo, d) - SCHEDULE_EPOCH_DAY) * MINUTES_PER_DAY + h * 60 + mi;
+        if (minutes <= INVALID_TIME || minutes > numeric_limits<TimeMinutes>::max()) return INVALID_TIME;
+        return static_cast<TimeMinutes>(minutes);
     }
+    if (sscanf(text.c_str(), "%d:%d%c", &h, &mi, &tail) == 2 && h >= 0 && h <= 23 && mi >= 0 && mi <= 59) {
+        return referenceDay * MINUTES_PER_DAY + h * 60 + mi;
+    }
+    return INVALID_TIME;
+}
 
-    bool confirmBooking() {
-        if (flight->bookSeat()) {
-            confirmed = true;
-            return true;
+inline string formatClock(TimeMinutes t) {
+    TimeMinutes inDay = t - dayOf(t) * MINUTES_PER_DAY;
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%02d:%02d", inDay / 60, inDay % 60);
+    return buf;
+}
+
+// "HH:MM" on the epoch day (the demo schedules), otherwise "YYYY-MM-DD HH:MM";
+// parseTime reads both back to the same value.
+inline string formatTime(TimeMinutes t) {
+    if (t == INVALID_TIME) return "--:--";
+    TimeMinutes day = dayOf(t);
+    if (day == 0) return formatClock(t);
+    int y, m, d;
+    civilFromDays(SCHEDULE_EPOCH_DAY + day, y, m, d);
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%04d-%02d-%02d ", y, m, d);
+    return buf + formatClock(t);
+}
+
+// ============================================================================
+// SHARED SEAT INVENTORY: seat counters and bitmaps in shared memory
+// ============================================================================
+
+// FNV-1a, used by the open-addressing indexes below
+inline uint64_t hashString(string_view text) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// One flight's inventory inside a shared-memory segment. Every field that
+// changes after setup is a lock-free atomic, so any process that maps the
+// segment can update it without locks. The counter is the authoritative
+// number of unsold seats; the bitmap records which specific seats have
+// been assigned.
+struct SharedFlightSlot {
+    static constexpr int MAX_SEATS = 512;
+    static constexpr int WORDS = MAX_SEATS / 64;
+    static constexpr uint32_t EMPTY = 0, CLAIMING = 1, READY = 2;
+
+    atomic<uint32_t> state;            // EMPTY -> CLAIMING -> READY
+    char flightNumber[16];
+    int32_t totalSeats;
+    atomic<int32_t> availableSeats;
+    atomic<uint64_t> version;          // bumped on every change
+    atomic<uint64_t> seatBits[WORDS];  // bit set = seat assigned
+
+    // Takes up to count seats; returns how many were granted
+    int takeSeats(int count) {
+        int32_t current = availableSeats.load(memory_order_relaxed);
+        while (current > 0) {
+            int32_t granted = min(current, static_cast<int32_t>(count));
+            if (availableSeats.compare_exchange_weak(current, current - granted, memory_order_acq_rel)) {
+                version.fetch_add(1, memory_order_release);
+                return granted;
+            }
+        }
+        return 0;
+    }
+
+    bool returnSeat() {
+        int32_t current = availableSeats.load(memory_order_relaxed);
+        while (current < totalSeats) {
+            if (availableSeats.compare_exchange_weak(current, current + 1, memory_order_acq_rel)) {
+                version.fetch_add(1, memory_order_release);
+                return true;
+            }
         }
         return false;
     }
 
-    void displayBooking() const {
-        cout << "Booking ID: " << bookingId << endl;
-        passenger->displayInfo();
-        cout << "Flight: " << flight->getFlightType() << endl;
-        flight->displayInfo();
-        cout << "Class: ";
-        switch (seatClass) {
-            case SeatClass::Economy: cout << "Economy"; break;
-            case SeatClass::Business: cout << "Business"; break;
-            case SeatClass::First: cout << "First"; break;
+    // Assigns the lowest free seat number, or returns -1
+    int claimFreeSeat() {
+        for (int w = 0; w < WORDS && w * 64 < totalSeats; w++) {
+            uint64_t bits = seatBits[w].load(memory_order_relaxed);
+            while (~bits != 0) {
+                int bit = __builtin_ctzll(~bits);
+                if (w * 64 + bit >= totalSeats) break;
+                if (seatBits[w].compare_exchange_weak(bits, bits | (1ULL << bit), memory_order_acq_rel)) {
+                    version.fetch_add(1, memory_order_release);
+                    return w * 64 + bit;
+                }
+            }
         }
-        cout << endl << "Total Price: $" << totalPrice << endl;
-        cout << "Status: " << (confirmed ? "Confirmed" : "Pending") << endl;
+        return -1;
     }
 
-    double getTotalPrice() const { return totalPrice; }
-    bool isConfirmed() const { return confirmed; }
-    shared_ptr<Flight> getFlight() const { return flight; }
-    shared_ptr<Passenger> getPassenger() const { return passenger; }
+    // Assigns a specific seat; false if someone already holds it
+    bool claimSeat(int seat) {
+        if (seat < 0 || seat >= totalSeats) return false;
+        uint64_t mask = 1ULL << (seat % 64);
+        bool won = !(seatBits[seat / 64].fetch_or(mask, memory_order_acq_rel) & mask);
+        if (won) version.fetch_add(1, memory_order_release);
+        return won;
+    }
+
+    void releaseSeatNumber(int seat) {
+        if (seat < 0 || seat >= totalSeats) return;
+        seatBits[seat / 64].fetch_and(~(1ULL << (seat % 64)), memory_order_acq_rel);
+        version.fetch_add(1, memory_order_release);
+    }
+
+    int assignedSeats() const {
+        int n = 0;
+        for (int w = 0; w < WORDS; w++) n += __builtin_popcountll(seatBits[w].load(memory_order_acquire));
+        return n;
+    }
 };
 
-// ============================================================================
-// FLIGHT BOOKING SYSTEM MANAGER
-// ============================================================================
+static_assert(atomic<int32_t>::is_always_lock_free && atomic<uint64_t>::is_always_lock_free,
+              "shared-memory inventory needs address-free lock-free atomics");
 
-class FlightBookingSystem {
+// A POSIX shared-memory segment holding a fixed-capacity open-addressing
+// table of SharedFlightSlots keyed by flight number. Workers map the same
+// segment and attach their Flight objects to the slots in place.
+class SharedSeatInventory {
 private:
-    vector<shared_ptr<Flight>> flights;
-    vector<shared_ptr<Booking>> bookings;
-    int bookingCounter;
+    static constexpr uint64_t MAGIC = 0x4642535345415431ULL; // "FBSSEAT1"
+
+    struct Header {
+        uint64_t magic;
+        uint32_t capacity; // power of two
+        atomic<uint32_t> flights;
+    };
+
+    void* base = nullptr;
+    size_t bytes = 0;
+    string name;
+    Header* header = nullptr;
+    SharedFlightSlot* slots = nullptr;
+
+    SharedSeatInventory() = default;
+
+    static size_t segmentSize(uint32_t capacity) {
+        return sizeof(Header) + alignof(SharedFlightSlot) + size_t(capacity) * sizeof(SharedFlightSlot);
+    }
+
+    bool map(int fd, size_t size) {
+#ifdef __linux__
+        base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (base == MAP_FAILED) { base = nullptr; return false; }
+        bytes = size;
+        header = static_cast<Header*>(base);
+        uintptr_t first = reinterpret_cast<uintptr_t>(base) + sizeof(Header);
+        first = (first + alignof(SharedFlightSlot) - 1) & ~(uintptr_t(alignof(SharedFlightSlot)) - 1);
+        slots = reinterpret_cast<SharedFlightSlot*>(first);
+        return true;
+#else
+        (void)fd; (void)size;
+        return false;
+#endif
+    }
+
+    static bool nameMatches(const SharedFlightSlot& slot, string_view flightNumber) {
+        return strncmp(slot.flightNumber, flightNumber.data(), flightNumber.size()) == 0 &&
+               slot.flightNumber[flightNumber.size()] == '\0';
+    }
 
 public:
-    FlightBookingSystem() : bookingCounter(1000) {}
+    SharedSeatInventory(const SharedSeatInventory&) = delete;
+    SharedSeatInventory& operator=(const SharedSeatInventory&) = delete;
 
-    void addFlight(shared_ptr<Flight> flight) {
-        flights.push_back(flight);
+    ~SharedSeatInventory() {
+#ifdef __linux__
+        if (base) munmap(base, bytes);
+#endif
     }
 
-    shared_ptr<Booking> createBooking(shared_ptr<Passenger> passenger, string flightNumber, SeatClass seatClass) {
-        for (auto& flight : flights) {
-            if (flight->getFlightNumber() == flightNumber) {
-                string bookingId = "BK" + to_string(bookingCounter++);
-                auto booking = make_shared<Booking>(bookingId, flight, passenger, seatClass);
-                bookings.push_back(booking);
-                return booking;
-            }
-        }
+    // Creates (or truncates) a named segment; name looks like "/fbs-inventory"
+    static unique_ptr<SharedSeatInventory> create(const string& name, uint32_t capacity) {
+#ifdef __linux__
+        uint32_t cap = 16;
+        while (cap < capacity * 2) cap <<= 1; // keep the table at most half full
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (fd < 0) return nullptr;
+        unique_ptr<SharedSeatInventory> inv(new SharedSeatInventory());
+        size_t size = segmentSize(cap);
+        bool ok = ftruncate(fd, size) == 0 && inv->map(fd, size); // new pages are zero: every slot EMPTY
+        ::close(fd);
+        if (!ok) return nullptr;
+        inv->name = name;
+        inv->header->capacity = cap;
+        inv->header->magic = MAGIC;
+        return inv;
+#else
+        (void)name; (void)capacity;
         return nullptr;
+#endif
     }
 
-    // ============================================================================
-    // SEARCH ALGORITHMS
-    // ============================================================================
+    static unique_ptr<SharedSeatInventory> open(const string& name) {
+#ifdef __linux__
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        unique_ptr<SharedSeatInventory> inv(new SharedSeatInventory());
+        bool ok = fstat(fd, &st) == 0 && inv->map(fd, st.st_size);
+        ::close(fd);
+        if (!ok || inv->header->magic != MAGIC || segmentSize(inv->header->capacity) > size_t(st.st_size)) return nullptr;
+        inv->name = name;
+        return inv;
+#else
+        (void)name;
+        return nullptr;
+#endif
+    }
 
-    // Linear search for flights by destination
-    shared_ptr<Flight> findFlightByDestination(const string& destination) const {
-        for (const auto& flight : flights) {
-            if (flight->getArrivalCity() == destination) {
-                return flight;
+    static void unlinkSegment(const string& name) {
+#ifdef __linux__
+        shm_unlink(name.c_str());
+#else
+        (void)name;
+#endif
+    }
+
+    SharedFlightSlot* find(string_view flightNumber) const {
+        uint32_t mask = header->capacity - 1;
+        for (uint32_t i = 0, pos = hashString(flightNumber) & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+            SharedFlightSlot& slot = slots[pos];
+            uint32_t st = slot.state.load(memory_order_acquire);
+            if (st == SharedFlightSlot::EMPTY) return nullptr;
+            while (st == SharedFlightSlot::CLAIMING) st = slot.state.load(memory_order_acquire);
+            if (nameMatches(slot, flightNumber)) return &slot;
+        }
+        return nullptr;
+    }
+
+    // Returns the flight's slot, creating it with all seats free if this is
+    // the first process to see the flight. Null if the table is full or the
+    // flight does not fit (long flight number, too many seats).
+    // A new slot starts with availableSeats unsold (the attaching process may
+    // already have sold some); an existing slot keeps the shared count
+    SharedFlightSlot* findOrInsert(string_view flightNumber, int totalSeats, int availableSeats) {
+        if (flightNumber.size() >= sizeof(SharedFlightSlot::flightNumber) ||
+            totalSeats > SharedFlightSlot::MAX_SEATS || totalSeats < 0) {
+            return nullptr;
+        }
+        uint32_t mask = header->capacity - 1;
+        for (uint32_t i = 0, pos = hashString(flightNumber) & mask; i <= mask; i++, pos = (pos + 1) & mask) {
+            SharedFlightSlot& slot = slots[pos];
+            uint32_t st = slot.state.load(memory_order_acquire);
+            if (st == SharedFlightSlot::EMPTY &&
+                slot.state.compare_exchange_strong(st, SharedFlightSlot::CLAIMING, memory_order_acq_rel)) {
+                memcpy(slot.flightNumber, flightNumber.data(), flightNumber.size());
+                slot.flightNumber[flightNumber.size()] = '\0';
+                slot.totalSeats = totalSeats;
+                slot.availableSeats.store(max(0, min(availableSeats, totalSeats)), memory_order_relaxed);
+                slot.state.store(SharedFlightSlot::READY, memory_order_release);
+                header->flights.fetch_add(1, memory_order_relaxed);
+                return &slot;
             }
+            while (st == SharedFlightSlot::CLAIMING) st = slot.state.load(memory_order_acquire);
+            if (nameMatches(slot, flightNumber)) return &slot;
         }
         return nullptr;
     }
 
-    // Linear search for flights within price range
-    vector<shared_ptr<Flight>> findFlightsByPriceRange(double minPrice, double maxPrice) const {
-        vector<shared_ptr<Flight>> results;
-        for (const auto& flight : flights) {
-            double price = flight->getBasePrice();
-            if (price >= minPrice && price <= maxPrice) {
-                results.push_back(flight);
+    uint32_t flightCount() const { return header->flights.load(memory_order_relaxed); }
+    const string& getName() const { return name; }
+};
+
+// ============================================================================
+// CORE CLASSES: Flight, Passenger, Booking System
+// ============================================================================
+
+// Notified whenever a flight's seat count or fare changes, so indexes built
+// over the inventory can stay in sync without rescanning every flight.
+// Seat counts are per flight; onClassSalesChanged says which cabin class a
+// booking took a seat in (+1) or gave one back from (-1).
+class InventoryListener {
+public:
+    virtual void onSeatsChanged(const Flight& flight) = 0;
+    virtual void onClassSalesChanged(const Flight& flight, SeatClass seatClass, int delta) = 0;
+    virtual void onFareChanged(const Flight& flight, double previousFare) = 0;
+    virtual ~InventoryListener() = default;
+};
+
+class Flight : public enable_shared_from_this<Flight> {
+protected:
+    string flightNumber;
+    string departureCity;
+    string arrivalCity;
+    TimeMinutes departure;
+    TimeMinutes arrival;
+    int totalSeats;
+    int availableSeats;
+    InventoryListener* listener = nullptr;
+    uint32_t inventorySlot = 0; // position in the owning system's flight list
+    SharedFlightSlot* sharedSeats = nullptr; // when set, seat counts live in shared memory
+    uint64_t sharedVersionSeen = 0;
+    double fareOverride = -1; // set by setFare; negative = the type's base price
+
+    void notifySeatsChanged() const {
+        if (listener) listener->onSeatsChanged(*this);
+    }
+
+public:
+    // Above any aircraft in service; keeps seat maps and their arithmetic small
+    static constexpr int MAX_SEATS = 1000;
+
+    static bool isValidSeatCount(int64_t seats) { return seats >= 1 && seats <= MAX_SEATS; }
+
+    Flight(string fn, string dep, string arr, const string& depTime, const string& arrTime, int seats)
+        : flightNumber(move(fn)), departureCity(move(dep)), arrivalCity(move(arr)),
+          departure(parseTime(depTime)), arrival(INVALID_TIME), totalSeats(seats), availableSeats(seats) {
+        // A bare arrival clock time is on the departure day, or the next one for overnight flights
+        if (departure != INVALID_TIME) {
+            arrival = parseTime(arrTime, dayOf(departure));
+            if (arrival != INVALID_TIME && arrival < departure && arrTime.find('-') == string::npos) {
+                arrival += MINUTES_PER_DAY;
             }
         }
-        return results;
     }
 
-    // Binary search for flights by price (assuming flights sorted by price)
-    shared_ptr<Flight> findCheapestFlight(double maxPrice) const {
-        // For binary search, we need sorted data - sort flights by price first
-        vector<shared_ptr<Flight>> sortedFlights = flights;
-        sort(sortedFlights.begin(), sortedFlights.end(),
-             [](const shared_ptr<Flight>& a, const shared_ptr<Flight>& b) {
-                 return a->getBasePrice() < b->getBasePrice();
-             });
+    virtual double getBasePrice() const = 0;
+    virtual string getFlightType() const = 0;
+
+    // Current selling price: the type's base price unless repriced
+    double getFare() const { return fareOverride >= 0 ? fareOverride : getBasePrice(); }
+
+    // Reprices the flight; bookings already made keep their price
+    void setFare(double fare) {
+        double previous = getFare();
+        fareOverride = fare;
+        if (listener && fare != previous) listener->onFareChanged(*this, previous);
+    }
+
+    bool bookSeat() {
+        if (sharedSeats) {
+            if (sharedSeats->takeSeats(1) == 0) return false;
+            notifySeatsChanged();
+            return true;
+        }
+        if (availableSeats > 0) {
+            availableSeats--;
+            notifySeatsChanged();
+            return true;
+        }
+        return false;
+    }
+
+    // Takes up to count seats in one update; returns how many were granted
+    int bookSeats(int count) {
+        if (sharedSeats) {
+            int taken = sharedSeats->takeSeats(count);
+            if (taken > 0) notifySeatsChanged();
+            return taken;
+        }
+        int granted = min(count, availableSeats);
+        if (granted > 0) {
+            availableSeats -= granted;
+            notifySeatsChanged();
+        }
+        return granted;
+    }
+
+    bool releaseSeat() {
+        if (sharedSeats) {
+            if (!sharedSeats->returnSeat()) return false;
+            notifySeatsChanged();
+            return true;
+        }
+        if (availableSeats < totalSeats) {
+            availableSeats++;
+            notifySeatsChanged();
+            return true;
+        }
+        return false;
+    }
+
+    // Called by bookings as they take or give back a seat in a class
+    void notifyClassSales(SeatClass seatClass, int delta) const {
+        if (listener) listener->onClassSalesChanged(*this, seatClass, delta);
+    }
+
+    void attachInventory(InventoryListener* l, uint32_t slot) {
+        listener = l;
+        inventorySlot = slot;
+    }
+
+    // Moves this flight's seat counts into a shared-memory slot (no copy of
+    // the local count: the slot already holds the shared truth)
+    void attachSharedSeats(SharedFlightSlot* slot) {
+        sharedSeats = slot;
+        sharedVersionSeen = slot ? slot->version.load(memory_order_acquire) : 0;
+    }
+
+    // True if another process changed the shared seats since the last call
+    bool pollSharedChanges() {
+        if (!sharedSeats) return false;
+        uint64_t v = sharedSeats->version.load(memory_order_acquire);
+        if (v == sharedVersionSeen) return false;
+        sharedVersionSeen = v;
+        return true;
+    }
+
+    SharedFlightSlot* getSharedSeats() const { return sharedSeats; }
+
+    void displayInfo() const {
+        printInfo(cout, getAvailableSeats());
+        cout.flush();
+    }
+
+    // Same output as displayInfo, with the seat count supplied by the caller
+    // (e.g. taken from an inventory snapshot). Does not flush.
+    void printInfo(ostream& out, int seatsAvailable) const {
+        out << flightNumber << ": " << departureCity << " -> " << arrivalCity
+            << " (" << formatTime(departure) << " - " << formatClock(arrival);
+        if (departure != INVALID_TIME && arrival != INVALID_TIME && dayOf(arrival) > dayOf(departure)) {
+            out << "+" << dayOf(arrival) - dayOf(departure);
+        }
+        out << ")" << '\n';
+        out << "Available seats: " << seatsAvailable << "/" << totalSeats << '\n';
+    }
+
+    // Getters for search operations
+    const string& getDepartureCity() const { return departureCity; }
+    const string& getArrivalCity() const { return arrivalCity; }
+    const string& getFlightNumber() const { return flightNumber; }
+    string getDepartureTime() const { return formatTime(departure); }
+    string getArrivalTime() const { return formatTime(arrival); }
+    TimeMinutes getDepartureMinutes() const { return departure; }
+    TimeMinutes getArrivalMinutes() const { return arrival; }
+    int getDurationMinutes() const { return arrival - departure; }
+    int getAvailableSeats() const {
+        return sharedSeats ? sharedSeats->availableSeats.load(memory_order_acquire) : availableSeats;
+    }
+    int getTotalSeats() const { return totalSeats; }
+    uint32_t getInventorySlot() const { return inventorySlot; }
+
+    virtual ~Flight() = default;
+};
+
+class DomesticFlight : public Flight {
+public:
+    DomesticFlight(string fn, string dep, string arr, const string& depTime, const string& arrTime, int seats)
+        : Flight(move(fn), move(dep), move(arr), depTime, arrTime, seats) {}
+
+    double getBasePrice() const override { return 5000.0; }
+    string getFlightType() const override { return "Domestic"; }
+};
+
+class InternationalFlight : public Flight {
+public:
+    InternationalFlight(string fn, string dep, string arr, const string& depTime, const string& arrTime, int seats)
+        : Flight(move(fn), move(dep), move(arr), depTime, arrTime, seats) {}
+
+    double getBasePrice() const override { return 25000.0; }
+    string getFlightType() const override { return "International"; }
+};
+
+enum class SeatClass { Economy, Business, First };
+
+enum class BookingStatus { Pending, Confirmed, Waitlisted, Cancelled };
+
+enum class SeatPreference { Any, Window, Aisle };
+
+// ============================================================================
+// STRING STORAGE: registry arena + compact handles
+// ============================================================================
+
+// Bump allocator for long-lived strings (details of registered passengers).
+// Memory is only returned when the arena itself is destroyed, so pointers
+// into it stay valid; passengers stored in it share ownership of it.
+class StringArena {
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    vector<unique_ptr<char[]>> blocks;
+    size_t used;      // bytes used in the current block
+    size_t reserved;  // total bytes owned
+    mutex arenaMutex;
+
+public:
+    StringArena() : used(BLOCK_SIZE), reserved(0) {}
+
+    const char* store(string_view text) {
+        lock_guard<mutex> guard(arenaMutex);
+        if (text.size() > BLOCK_SIZE / 4) {
+            // Oversized strings get a block of their own; keep the current one open
+            blocks.insert(blocks.begin(), make_unique<char[]>(text.size()));
+            reserved += text.size();
+            memcpy(blocks.front().get(), text.data(), text.size());
+            return blocks.front().get();
+        }
+        if (used + text.size() > BLOCK_SIZE) {
+            blocks.push_back(make_unique<char[]>(BLOCK_SIZE));
+            reserved += BLOCK_SIZE;
+            used = 0;
+        }
+        char* dest = blocks.back().get() + used;
+        memcpy(dest, text.data(), text.size());
+        used += text.size();
+        return dest;
+    }
+
+    size_t bytesReserved() const { return reserved; }
+};
+
+// 16-byte string handle. Up to 15 characters are stored inline (names,
+// passport numbers and phone numbers usually fit); longer strings point
+// into a StringArena or a buffer owned by the passenger.
+class CompactString {
+private:
+    static constexpr size_t INLINE_CAPACITY = 15;
+    static constexpr uint8_t OUT_OF_LINE = 0xFF;
+    char bytes[INLINE_CAPACITY]; // inline text, or {const char*, uint32_t} when out of line
+    uint8_t tag;                 // inline length, or OUT_OF_LINE
+
+public:
+    CompactString() : bytes{}, tag(0) {}
+
+    CompactString(string_view text, StringArena& arena) : bytes{} {
+        if (text.size() <= INLINE_CAPACITY) {
+            memcpy(bytes, text.data(), text.size());
+            tag = static_cast<uint8_t>(text.size());
+        } else {
+            const char* ptr = arena.store(text);
+            uint32_t len = static_cast<uint32_t>(text.size());
+            memcpy(bytes, &ptr, sizeof(ptr));
+            memcpy(bytes + sizeof(ptr), &len, sizeof(len));
+            tag = OUT_OF_LINE;
+        }
+    }
+
+    // Long text is copied to `spill`, which is advanced past it
+    CompactString(string_view text, char*& spill) : bytes{} {
+        if (text.size() <= INLINE_CAPACITY) {
+            memcpy(bytes, text.data(), text.size());
+            tag = static_cast<uint8_t>(text.size());
+        } else {
+            const char* ptr = spill;
+            uint32_t len = static_cast<uint32_t>(text.size());
+            memcpy(spill, text.data(), text.size());
+            spill += text.size();
+            memcpy(bytes, &ptr, sizeof(ptr));
+            memcpy(bytes + sizeof(ptr), &len, sizeof(len));
+            tag = OUT_OF_LINE;
+        }
+    }
+
+    static bool fitsInline(string_view text) { return text.size() <= INLINE_CAPACITY; }
+
+    string_view view() const {
+        if (tag != OUT_OF_LINE) return string_view(bytes, tag);
+        const char* ptr;
+        uint32_t len;
+        memcpy(&ptr, bytes, sizeof(ptr));
+        memcpy(&len, bytes + sizeof(ptr), sizeof(len));
+        return string_view(ptr, len);
+    }
+};
+
+class Passenger {
+private:
+    shared_ptr<StringArena> arena; // registry arena holding the long strings, if any
+    unique_ptr<char[]> ownText;    // otherwise the long strings live here
+    CompactString name;
+    CompactString passportNumber;
+    CompactString contactNumber;
+    CompactString email;
+
+    static size_t spillSize(initializer_list<string_view> fields) {
+        size_t bytes = 0;
+        for (string_view f : fields) bytes += CompactString::fitsInline(f) ? 0 : f.size();
+        return bytes;
+    }
+
+public:
+    // Standalone passenger: freed with the object
+    Passenger(string_view n, string_view pass, string_view contact, string_view mail) {
+        size_t bytes = spillSize({n, pass, contact, mail});
+        if (bytes) ownText = make_unique<char[]>(bytes);
+        char* spill = ownText.get();
+        name = CompactString(n, spill);
+        passportNumber = CompactString(pass, spill);
+        contactNumber = CompactString(contact, spill);
+        email = CompactString(mail, spill);
+    }
+
+    // Registry record: long strings go into the registry's arena
+    Passenger(string_view n, string_view pass, string_view contact, string_view mail, shared_ptr<StringArena> a)
+        : arena(move(a)), name(n, *arena), passportNumber(pass, *arena), contactNumber(contact, *arena),
+          email(mail, *arena) {}
+
+    string_view getName() const { return name.view(); }
+    string_view getPassport() const { return passportNumber.view(); }
+    string_view getContact() const { return contactNumber.view(); }
+    string_view getEmail() const { return email.view(); }
+
+    void displayInfo() const {
+        printInfo(cout);
+        cout.flush();
+    }
+
+    // Does not flush
+    void printInfo(ostream& out) const {
+        out << "Name: " << getName() << '\n';
+        out << "Passport: " << getPassport() << '\n';
+        out << "Contact: " << getContact() << '\n';
+        out << "Email: " << getEmail() << '\n';
+    }
+};
+
+class Booking : public enable_shared_from_this<Booking> {
+private:
+    BookingId bookingId;
+    shared_ptr<Flight> flight;
+    shared_ptr<Passenger> passenger;
+    SeatClass seatClass;
+    double totalPrice;
+    BookingStatus status;
+    int seatNumber = -1; // assigned seat, -1 until seat selection
+    bool seatHeld = false; // pending, but already holds a seat (see holdSeat)
+    Booking* nextForPassenger = nullptr; // intrusive link, owned by PassengerRegistry
+    friend class PassengerRegistry;
+    friend class FlightBookingSystem; // moves bookings on and off its waitlists
+
+    // Waitlisted bookings are confirmed only by the system, in waitlist order
+    bool confirmFromWaitlist() {
+        if (status != BookingStatus::Waitlisted || !flight->bookSeat()) return false;
+        status = BookingStatus::Confirmed;
+        flight->notifyClassSales(seatClass, +1);
+        return true;
+    }
+
+    // Confirms against a seat the caller has already taken from the flight
+    bool confirmReservedSeat() {
+        if (seatHeld || (status != BookingStatus::Pending && status != BookingStatus::Waitlisted)) return false;
+        status = BookingStatus::Confirmed;
+        flight->notifyClassSales(seatClass, +1);
+        return true;
+    }
+
+    void markWaitlisted() {
+        if (status == BookingStatus::Pending) status = BookingStatus::Waitlisted;
+    }
+
+    // Returns true if a seat was given back to the flight
+    bool cancel() {
+        bool hadSeat = status == BookingStatus::Confirmed || seatHeld;
+        seatHeld = false;
+        status = BookingStatus::Cancelled;
+        if (hadSeat) flight->notifyClassSales(seatClass, -1);
+        return hadSeat && flight->releaseSeat();
+    }
+
+public:
+    Booking(BookingId id, shared_ptr<Flight> f, shared_ptr<Passenger> p, SeatClass sc)
+        : bookingId(id), flight(move(f)), passenger(move(p)), seatClass(sc), status(BookingStatus::Pending) {
+        calculatePrice();
+    }
+
+    void calculatePrice() {
+        double basePrice = flight->getFare();
+        double multiplier = 1.0;
+        switch (seatClass) {
+            case SeatClass::Economy: multiplier = 1.0; break;
+            case SeatClass::Business: multiplier = 2.5; break;
+            case SeatClass::First: multiplier = 4.0; break;
+        }
+        totalPrice = basePrice * multiplier;
+    }
+
+    // Pending bookings only; waitlisted ones wait for promotion
+    bool confirmBooking() {
+        FBS_METRIC_SCOPE(MetricOp::ConfirmBooking);
+        if (status != BookingStatus::Pending) return false;
+        if (seatHeld || flight->bookSeat()) {
+            if (!seatHeld) flight->notifyClassSales(seatClass, +1);
+            seatHeld = false;
+            status = BookingStatus::Confirmed;
+            return true;
+        }
+        FBS_METRIC_FAILURE(MetricOp::ConfirmBooking);
+        return false;
+    }
+
+    // Takes a seat for a pending booking without confirming it
+    bool holdSeat() {
+        if (status != BookingStatus::Pending || seatHeld || !flight->bookSeat()) return false;
+        seatHeld = true;
+        flight->notifyClassSales(seatClass, +1);
+        return true;
+    }
+
+    // Returns true if a held seat was given back to the flight
+    bool releaseHeldSeat() {
+        if (!seatHeld) return false;
+        seatHeld = false;
+        flight->notifyClassSales(seatClass, -1);
+        return flight->releaseSeat();
+    }
+
+    bool hasHeldSeat() const { return seatHeld; }
+
+    void displayBooking() const {
+        printBooking(cout);
+        cout.flush();
+    }
+
+    // Does not flush, so exporters can format many records into one buffer
+    void printBooking(ostream& out) const {
+        out << "Booking ID: " << formatBookingId(bookingId) << '\n';
+        passenger->printInfo(out);
+        out << "Flight: " << flight->getFlightType() << '\n';
+        flight->printInfo(out, flight->getAvailableSeats());
+        out << "Class: ";
+        switch (seatClass) {
+            case SeatClass::Economy: out << "Economy"; break;
+            case SeatClass::Business: out << "Business"; break;
+            case SeatClass::First: out << "First"; break;
+        }
+        out << '\n' << "Total Price: $" << totalPrice << '\n';
+        out << "Status: ";
+        switch (status) {
+            case BookingStatus::Pending: out << "Pending"; break;
+            case BookingStatus::Confirmed: out << "Confirmed"; break;
+            case BookingStatus::Waitlisted: out << "Waitlisted"; break;
+            case BookingStatus::Cancelled: out << "Cancelled"; break;
+        }
+        out << '\n';
+    }
+
+    BookingId getBookingId() const { return bookingId; }
+    double getTotalPrice() const { return totalPrice; }
+    SeatClass getSeatClass() const { return seatClass; }
+    BookingStatus getStatus() const { return status; }
+    int getSeatNumber() const { return seatNumber; }
+    void setSeatNumber(int seat) { seatNumber = seat; }
+    bool isConfirmed() const { return status == BookingStatus::Confirmed; }
+    shared_ptr<Flight> getFlight() const { return flight; }
+    shared_ptr<Passenger> getPassenger() const { return passenger; }
+};
+
+// ============================================================================
+// WAITLIST: per-flight binary heap ordered by fare class, then request time
+// ============================================================================
+
+class Waitlist {
+private:
+    struct Entry {
+        SeatClass seatClass;
+        BookingId requestId; // IDs are time-ordered, so they double as request time
+        shared_ptr<Booking> booking;
+    };
+
+    // Max-heap: higher fare class first, then earlier request
+    struct LowerPriority {
+        bool operator()(const Entry& a, const Entry& b) const {
+            if (a.seatClass != b.seatClass) return a.seatClass < b.seatClass;
+            return a.requestId > b.requestId;
+        }
+    };
+
+    vector<Entry> heap;
+    size_t stale = 0; // entries whose booking left the waitlist; dropped lazily on pop
+
+public:
+    void push(const shared_ptr<Booking>& booking) {
+        heap.push_back(Entry{booking->getSeatClass(), booking->getBookingId(), booking});
+        push_heap(heap.begin(), heap.end(), LowerPriority());
+    }
+
+    // Next booking still waiting for a seat, or null. O(log n) amortized.
+    // Every entry it discards leaves the count, so size() can only be off
+    // until the stale entries reach the top of the heap.
+    shared_ptr<Booking> pop() {
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), LowerPriority());
+            shared_ptr<Booking> booking = move(heap.back().booking);
+            heap.pop_back();
+            if (booking->getStatus() == BookingStatus::Waitlisted) return booking;
+            if (stale > 0) stale--;
+        }
+        stale = 0;
+        return nullptr;
+    }
+
+    // A waitlisted booking was cancelled or confirmed elsewhere; its heap
+    // entry is dropped on a later pop
+    void forget() {
+        if (stale < heap.size()) stale++;
+    }
+
+    size_t size() const { return heap.size() - stale; }
+};
+
+// ============================================================================
+// PASSENGER REGISTRY: one record per passport, open-addressing index
+// ============================================================================
+
+class PassengerRegistry {
+private:
+    static constexpr uint32_t EMPTY = numeric_limits<uint32_t>::max();
+
+    struct IndexEntry {
+        uint32_t hashTag; // low 32 bits of the passport hash, checked before comparing strings
+        uint32_t slot;    // index into passengers, or EMPTY
+    };
+
+    // Each passenger's bookings are chained through Booking::nextForPassenger,
+    // so adding one never allocates. The system owns the bookings.
+    struct BookingList {
+        Booking* head = nullptr;
+        Booking* tail = nullptr;
+        size_t count = 0;
+    };
+
+    vector<shared_ptr<Passenger>> passengers;               // slot -> passenger
+    vector<BookingList> bookingsBySlot;                     // slot -> bookings, oldest first
+    vector<IndexEntry> table;                               // linear probing, power-of-two size
+    shared_ptr<StringArena> arena = make_shared<StringArena>(); // only passengers registered here
+
+    // Returns the table position holding this passport, or the empty position where it belongs
+    size_t probe(string_view passport, uint64_t h) const {
+        size_t mask = table.size() - 1;
+        size_t pos = h & mask;
+        while (table[pos].slot != EMPTY) {
+            if (table[pos].hashTag == static_cast<uint32_t>(h) &&
+                passengers[table[pos].slot]->getPassport() == passport) {
+                break;
+            }
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void grow() {
+        vector<IndexEntry> old(table.size() * 2, IndexEntry{0, EMPTY});
+        old.swap(table);
+        for (const auto& entry : old) {
+            if (entry.slot == EMPTY) continue;
+            size_t pos = probe(passengers[entry.slot]->getPassport(), hashString(passengers[entry.slot]->getPassport()));
+            table[pos] = entry;
+        }
+    }
+
+public:
+    PassengerRegistry() : table(64, IndexEntry{0, EMPTY}) {}
+
+    // Returns the slot of the passenger with this passport, registering it if new.
+    // A passenger already on file wins over the incoming duplicate.
+    uint32_t intern(const shared_ptr<Passenger>& passenger) {
+        string_view passport = passenger->getPassport();
+        uint64_t h = hashString(passport);
+        size_t pos = probe(passport, h);
+        if (table[pos].slot != EMPTY) return table[pos].slot;
+
+        uint32_t slot = static_cast<uint32_t>(passengers.size());
+        passengers.push_back(passenger);
+        bookingsBySlot.emplace_back();
+        table[pos] = IndexEntry{static_cast<uint32_t>(h), slot};
+        if (passengers.size() * 10 > table.size() * 7) grow(); // keep load factor <= 0.7
+        return slot;
+    }
+
+    shared_ptr<Passenger> registerPassenger(string_view name, string_view passport,
+                                            string_view contact, string_view email) {
+        auto existing = findByPassport(passport);
+        if (existing) return existing;
+        return passengers[intern(make_shared<Passenger>(name, passport, contact, email, arena))];
+    }
+
+    shared_ptr<Passenger> findByPassport(string_view passport) const {
+        size_t pos = probe(passport, hashString(passport));
+        return table[pos].slot != EMPTY ? passengers[table[pos].slot] : nullptr;
+    }
+
+    const shared_ptr<Passenger>& passengerAt(uint32_t slot) const { return passengers[slot]; }
+
+    void addBooking(uint32_t slot, Booking& booking) {
+        BookingList& list = bookingsBySlot[slot];
+        booking.nextForPassenger = nullptr;
+        (list.tail ? list.tail->nextForPassenger : list.head) = &booking;
+        list.tail = &booking;
+        list.count++;
+    }
+
+    // Unlinks bookings matching pred(const Booking&) from every passenger's
+    // list; returns how many. The caller drops them from its own storage.
+    template <typename Pred>
+    size_t removeBookings(Pred&& pred) {
+        size_t removed = 0;
+        for (auto& list : bookingsBySlot) {
+            Booking** link = &list.head;
+            list.tail = nullptr;
+            while (Booking* booking = *link) {
+                if (pred(*booking)) {
+                    *link = booking->nextForPassenger;
+                    list.count--;
+                    removed++;
+                } else {
+                    list.tail = booking;
+                    link = &booking->nextForPassenger;
+                }
+            }
+        }
+        return removed;
+    }
+
+    vector<shared_ptr<Booking>> bookingsFor(string_view passport) const {
+        vector<shared_ptr<Booking>> result;
+        size_t pos = probe(passport, hashString(passport));
+        if (table[pos].slot == EMPTY) return result;
+        const BookingList& list = bookingsBySlot[table[pos].slot];
+        result.reserve(list.count);
+        for (Booking* b = list.head; b; b = b->nextForPassenger) result.push_back(b->shared_from_this());
+        return result;
+    }
+
+    size_t size() const { return passengers.size(); }
+};
+
+// ============================================================================
+// FLIGHT QUERY ENGINE: composite indexes, compact records, cursors
+// ============================================================================
+
+// Maps city names to dense integer IDs so indexes and records can compare ints
+class CityDictionary {
+private:
+    unordered_map<string, uint32_t> ids;
+    vector<string> names;
+
+public:
+    static constexpr uint32_t UNKNOWN = numeric_limits<uint32_t>::max();
+
+    uint32_t intern(const string& city) {
+        auto it = ids.find(city);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(names.size());
+        ids.emplace(city, id);
+        names.push_back(city);
+        return id;
+    }
+
+    uint32_t lookup(const string& city) const {
+        auto it = ids.find(city);
+        return it != ids.end() ? it->second : UNKNOWN;
+    }
+
+    const string& name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+};
+
+// Combined search criteria; unset fields match everything
+struct FlightQuery {
+    string origin;
+    string destination;
+    TimeMinutes departAfter = numeric_limits<TimeMinutes>::min();  // inclusive
+    TimeMinutes departBefore = numeric_limits<TimeMinutes>::max(); // inclusive
+    double minPrice = 0.0;
+    double maxPrice = numeric_limits<double>::infinity();
+    int minFreeSeats = 0;
+};
+
+// Everything a predicate needs, packed so a scan touches one cache line per
+// two flights instead of chasing shared_ptrs and virtual calls.
+struct FlightRecord {
+    uint32_t origin;
+    uint32_t destination;
+    TimeMinutes departure;
+    TimeMinutes arrival;
+    int32_t freeSeats;
+    double price;
+    const Flight* flight;
+};
+
+class FlightQueryEngine;
+
+// Streams matches page by page. Holds only positions into the engine's
+// indexes, so it is invalidated by addFlight (seat changes are fine).
+class FlightCursor {
+private:
+    const FlightQueryEngine* engine = nullptr;
+    const vector<uint32_t>* candidates = nullptr; // index list chosen by the planner, or null for a full scan
+    size_t position = 0;
+    size_t end = 0;
+    int minFreeSeats = 0;
+    double minPrice = 0.0, maxPrice = 0.0;
+    TimeMinutes departAfter = 0, departBefore = 0;
+
+    friend class FlightQueryEngine;
+    bool matches(const FlightRecord& r) const;
+
+public:
+    // Fills up to pageSize pointers; returns how many were written (0 = exhausted)
+    size_t nextPage(const Flight** page, size_t pageSize);
+
+    bool next(const Flight*& flight) { return nextPage(&flight, 1) == 1; }
+    bool hasMore() const { return position < end; }
+};
+
+class FlightQueryEngine {
+private:
+    CityDictionary cities;
+    vector<FlightRecord> records;                         // one per flight, by inventory slot
+    unordered_map<uint64_t, vector<uint32_t>> byRoute;    // (origin, destination) -> slots
+    vector<vector<uint32_t>> byOrigin;                    // origin -> slots
+    vector<vector<uint32_t>> byDestination;               // destination -> slots
+    vector<uint32_t> byDeparture;                         // all slots
+
+    friend class FlightCursor;
+
+    static uint64_t routeKey(uint32_t origin, uint32_t destination) {
+        return (static_cast<uint64_t>(origin) << 32) | destination;
+    }
+
+    // Every index list is kept ordered by departure so the planner can
+    // binary-search the departure window instead of filtering it.
+    void insertOrdered(vector<uint32_t>& list, uint32_t slot) {
+        auto pos = upper_bound(list.begin(), list.end(), records[slot].departure,
+                               [this](TimeMinutes dep, uint32_t s) { return dep < records[s].departure; });
+        list.insert(pos, slot);
+    }
+
+public:
+    void addFlight(const Flight& flight) {
+        uint32_t slot = flight.getInventorySlot();
+        uint32_t origin = cities.intern(flight.getDepartureCity());
+        uint32_t destination = cities.intern(flight.getArrivalCity());
+        if (records.size() <= slot) records.resize(slot + 1);
+        records[slot] = FlightRecord{origin, destination, flight.getDepartureMinutes(), flight.getArrivalMinutes(),
+                                     flight.getAvailableSeats(), flight.getFare(), &flight};
+
+        if (byOrigin.size() < cities.size()) byOrigin.resize(cities.size());
+        if (byDestination.size() < cities.size()) byDestination.resize(cities.size());
+        insertOrdered(byRoute[routeKey(origin, destination)], slot);
+        insertOrdered(byOrigin[origin], slot);
+        insertOrdered(byDestination[destination], slot);
+        insertOrdered(byDeparture, slot);
+    }
+
+    void updateSeats(const Flight& flight) {
+        records[flight.getInventorySlot()].freeSeats = flight.getAvailableSeats();
+    }
+
+    void updatePrice(const Flight& flight) {
+        records[flight.getInventorySlot()].price = flight.getFare();
+    }
+
+    // Range scan of the per-origin departure index: O(log n + k).
+    // fn(const FlightRecord&) is called in departure order.
+    template <typename Fn>
+    void forEachDeparture(const string& origin, TimeMinutes from, TimeMinutes to, Fn&& fn) const {
+        uint32_t id = cities.lookup(origin);
+        if (id == CityDictionary::UNKNOWN) return;
+        const vector<uint32_t>& list = byOrigin[id];
+        auto it = lower_bound(list.begin(), list.end(), from,
+                              [this](uint32_t s, TimeMinutes t) { return records[s].departure < t; });
+        for (; it != list.end() && records[*it].departure <= to; ++it) fn(records[*it]);
+    }
+
+    const CityDictionary& getCities() const { return cities; }
+    const FlightRecord& record(uint32_t slot) const { return records[slot]; }
+    size_t size() const { return records.size(); }
+
+    // Slots flying origin -> destination (city IDs), ordered by departure
+    const vector<uint32_t>& flightsOnRoute(uint32_t origin, uint32_t destination) const {
+        static const vector<uint32_t> none;
+        auto it = byRoute.find(routeKey(origin, destination));
+        return it != byRoute.end() ? it->second : none;
+    }
+
+    // Slots departing from a city, ordered by departure
+    const vector<uint32_t>& departuresFrom(uint32_t city) const {
+        static const vector<uint32_t> none;
+        return city < byOrigin.size() ? byOrigin[city] : none;
+    }
+
+    // Picks the most selective index for the query, then narrows it to the
+    // departure window. Remaining predicates run on the compact records.
+    FlightCursor query(const FlightQuery& q) const {
+        static const vector<uint32_t> none;
+        FlightCursor cursor;
+        cursor.engine = this;
+        cursor.minFreeSeats = q.minFreeSeats;
+        cursor.minPrice = q.minPrice;
+        cursor.maxPrice = q.maxPrice;
+        cursor.departAfter = q.departAfter;
+        cursor.departBefore = q.departBefore;
+
+        uint32_t origin = q.origin.empty() ? CityDictionary::UNKNOWN : cities.lookup(q.origin);
+        uint32_t destination = q.destination.empty() ? CityDictionary::UNKNOWN : cities.lookup(q.destination);
+        bool originMissing = !q.origin.empty() && origin == CityDictionary::UNKNOWN;
+        bool destinationMissing = !q.destination.empty() && destination == CityDictionary::UNKNOWN;
+
+        const vector<uint32_t>* list = &byDeparture;
+        if (originMissing || destinationMissing) {
+            list = &none;
+        } else if (!q.origin.empty() && !q.destination.empty()) {
+            auto it = byRoute.find(routeKey(origin, destination));
+            list = it != byRoute.end() ? &it->second : &none;
+        } else if (!q.origin.empty()) {
+            list = &byOrigin[origin];
+        } else if (!q.destination.empty()) {
+            list = &byDestination[destination];
+        }
+
+        auto lo = lower_bound(list->begin(), list->end(), q.departAfter,
+                              [this](uint32_t s, TimeMinutes dep) { return records[s].departure < dep; });
+        auto hi = upper_bound(lo, list->end(), q.departBefore,
+                              [this](TimeMinutes dep, uint32_t s) { return dep < records[s].departure; });
+        cursor.candidates = list;
+        cursor.position = lo - list->begin();
+        cursor.end = hi - list->begin();
+        return cursor;
+    }
+};
+
+inline bool FlightCursor::matches(const FlightRecord& r) const {
+    return r.freeSeats >= minFreeSeats && r.price >= minPrice && r.price <= maxPrice;
+}
+
+inline size_t FlightCursor::nextPage(const Flight** page, size_t pageSize) {
+    size_t written = 0;
+    while (written < pageSize && position < end) {
+        const FlightRecord& r = engine->records[(*candidates)[position++]];
+        if (matches(r)) page[written++] = r.flight;
+    }
+    return written;
+}
+
+// ============================================================================
+// INVENTORY SNAPSHOTS: lock-free reads, epoch-based reclamation
+// ============================================================================
+
+// Small dense IDs for threads that read snapshots, recycled when a thread
+// exits. Returns -1 once MAX_READERS threads hold one.
+class ReaderThreadIds {
+public:
+    static constexpr int MAX_READERS = 256;
+
+private:
+    mutex idMutex;
+    vector<int> freeIds;
+    int nextId = 0;
+    atomic<int> highWater{0}; // one past the largest ID ever handed out
+
+    struct Holder {
+        int id;
+        Holder() : id(instance().acquire()) {}
+        ~Holder() { if (id >= 0) instance().release(id); }
+    };
+
+    int acquire() {
+        lock_guard<mutex> guard(idMutex);
+        if (!freeIds.empty()) { int id = freeIds.back(); freeIds.pop_back(); return id; }
+        if (nextId >= MAX_READERS) return -1;
+        highWater.store(nextId + 1, memory_order_release);
+        return nextId++;
+    }
+
+    void release(int id) {
+        lock_guard<mutex> guard(idMutex);
+        freeIds.push_back(id);
+    }
+
+public:
+    static ReaderThreadIds& instance() {
+        static ReaderThreadIds ids;
+        return ids;
+    }
+
+    static int current() {
+        thread_local Holder holder;
+        return holder.id;
+    }
+
+    static int limit() { return instance().highWater.load(memory_order_acquire); }
+};
+
+// Immutable, versioned copies of per-flight seat and price data.
+//
+// A version is a table of pointers to fixed-size chunks of entries. A writer
+// copies only the chunk it changes plus the pointer table, then swaps the
+// current version pointer. Readers announce the global epoch in their own
+// slot, load the pointer and read without locks. A replaced version (and its
+// replaced chunk) is recycled once every announced epoch is newer than the
+// one it was retired in. Recycled objects go to free lists, so steady-state
+// writes do not allocate.
+//
+// Writers are serialized internally; readers never block and never see a
+// half-applied change.
+class InventorySnapshots {
+public:
+    static constexpr size_t CHUNK_SIZE = 64;
+
+    struct SeatEntry {
+        Flight* flight;
+        double price;
+        int32_t availableSeats;
+        int32_t totalSeats;
+    };
+
+    struct Chunk {
+        array<SeatEntry, CHUNK_SIZE> entries;
+    };
+
+    class Version {
+    private:
+        vector<Chunk*> chunks;
+        size_t count = 0;
+        uint64_t number = 0;
+        friend class InventorySnapshots;
+
+    public:
+        size_t size() const { return count; }
+        uint64_t versionNumber() const { return number; }
+        const SeatEntry& operator[](size_t i) const { return chunks[i / CHUNK_SIZE]->entries[i % CHUNK_SIZE]; }
+    };
+
+private:
+    struct alignas(64) ReaderSlot {
+        atomic<uint64_t> epoch{0}; // 0 = not reading
+    };
+
+    struct Retired {
+        Version* version;
+        Chunk* chunk;   // chunk replaced by the newer version, may be null
+        uint64_t epoch;
+    };
+
+    atomic<Version*> current{nullptr};
+    atomic<uint64_t> globalEpoch{1};
+    mutable array<ReaderSlot, ReaderThreadIds::MAX_READERS> readers;
+
+    mutable mutex writerMutex;
+    vector<Retired> retired;
+    vector<Version*> freeVersions;
+    vector<Chunk*> freeChunks;
+    vector<unique_ptr<Version>> ownedVersions;
+    vector<unique_ptr<Chunk>> ownedChunks;
+
+    Version* newVersion() {
+        if (!freeVersions.empty()) { Version* v = freeVersions.back(); freeVersions.pop_back(); return v; }
+        ownedVersions.push_back(make_unique<Version>());
+        return ownedVersions.back().get();
+    }
+
+    Chunk* newChunk() {
+        if (!freeChunks.empty()) { Chunk* c = freeChunks.back(); freeChunks.pop_back(); return c; }
+        ownedChunks.push_back(make_unique<Chunk>());
+        return ownedChunks.back().get();
+    }
+
+    void reclaim() {
+        uint64_t oldestActive = numeric_limits<uint64_t>::max();
+        int limit = ReaderThreadIds::limit();
+        for (int i = 0; i < limit; i++) {
+            uint64_t e = readers[i].epoch.load(memory_order_seq_cst);
+            if (e != 0) oldestActive = min(oldestActive, e);
+        }
+        size_t kept = 0;
+        for (const Retired& r : retired) {
+            if (r.epoch < oldestActive) {
+                freeVersions.push_back(r.version);
+                if (r.chunk) freeChunks.push_back(r.chunk);
+            } else {
+                retired[kept++] = r;
+            }
+        }
+        retired.resize(kept);
+    }
+
+    // Builds the next version from the current one, replacing chunk c
+    // (c == chunk count appends a new chunk). Caller holds writerMutex.
+    Version* copyOnWrite(size_t c, Chunk*& replaced) {
+        Version* old = current.load(memory_order_relaxed);
+        Version* next = newVersion();
+        next->chunks.assign(old->chunks.begin(), old->chunks.end());
+        next->count = old->count;
+        next->number = old->number + 1;
+        Chunk* fresh = newChunk();
+        if (c < next->chunks.size()) {
+            *fresh = *next->chunks[c];
+            replaced = next->chunks[c];
+            next->chunks[c] = fresh;
+        } else {
+            replaced = nullptr;
+            next->chunks.push_back(fresh);
+        }
+        return next;
+    }
+
+    void publish(Version* next, Chunk* replaced) {
+        Version* old = current.exchange(next, memory_order_seq_cst);
+        uint64_t epoch = globalEpoch.fetch_add(1, memory_order_seq_cst);
+        retired.push_back(Retired{old, replaced, epoch});
+        reclaim();
+    }
+
+public:
+    InventorySnapshots() { current.store(newVersion()); }
+
+    // Every reclaimed or live object is owned by the owned* vectors
+    ~InventorySnapshots() = default;
+
+    InventorySnapshots(const InventorySnapshots&) = delete;
+    InventorySnapshots& operator=(const InventorySnapshots&) = delete;
+
+    void addFlight(Flight& flight) {
+        lock_guard<mutex> guard(writerMutex);
+        size_t slot = flight.getInventorySlot();
+        Chunk* replaced;
+        Version* next = copyOnWrite(slot / CHUNK_SIZE, replaced);
+        next->chunks[slot / CHUNK_SIZE]->entries[slot % CHUNK_SIZE] =
+            SeatEntry{&flight, flight.getFare(), flight.getAvailableSeats(), flight.getTotalSeats()};
+        next->count = max(next->count, slot + 1);
+        publish(next, replaced);
+    }
+
+    void updateSeats(const Flight& flight) {
+        lock_guard<mutex> guard(writerMutex);
+        size_t slot = flight.getInventorySlot();
+        Chunk* replaced;
+        Version* next = copyOnWrite(slot / CHUNK_SIZE, replaced);
+        next->chunks[slot / CHUNK_SIZE]->entries[slot % CHUNK_SIZE].availableSeats = flight.getAvailableSeats();
+        publish(next, replaced);
+    }
+
+    void updatePrice(const Flight& flight) {
+        lock_guard<mutex> guard(writerMutex);
+        size_t slot = flight.getInventorySlot();
+        Chunk* replaced;
+        Version* next = copyOnWrite(slot / CHUNK_SIZE, replaced);
+        next->chunks[slot / CHUNK_SIZE]->entries[slot % CHUNK_SIZE].price = flight.getFare();
+        publish(next, replaced);
+    }
+
+    // Runs fn(const Version&) against the current version without taking a
+    // lock. The version must not be used after fn returns.
+    template <typename Fn>
+    auto read(Fn&& fn) const {
+        int id = ReaderThreadIds::current();
+        if (id < 0) {
+            // Out of reader slots: fall back to excluding writers
+            lock_guard<mutex> guard(writerMutex);
+            return fn(*current.load(memory_order_acquire));
+        }
+        atomic<uint64_t>& slot = readers[id].epoch;
+        bool outermost = slot.load(memory_order_relaxed) == 0;
+        if (outermost) slot.store(globalEpoch.load(memory_order_seq_cst), memory_order_seq_cst);
+        struct Exit {
+            atomic<uint64_t>& slot;
+            bool outermost;
+            ~Exit() { if (outermost) slot.store(0, memory_order_release); }
+        } exitGuard{slot, outermost};
+        return fn(*current.load(memory_order_seq_cst));
+    }
+
+    uint64_t versionNumber() const {
+        return read([](const Version& v) { return v.versionNumber(); });
+    }
+};
+
+// ============================================================================
+// QUERY RESULT CACHE: CLOCK-evicted results of repeated searches
+// ============================================================================
+
+struct QueryCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+
+    double hitRate() const { return hits + misses ? double(hits) / double(hits + misses) : 0.0; }
+};
+
+// Case-folded, trimmed, inner whitespace collapsed: the form city names and
+// search terms are matched in ("  New  Delhi " -> "new delhi")
+inline string normalizeSearchText(string_view text) {
+    string key;
+    key.reserve(text.size());
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isspace(u)) {
+            if (!key.empty() && key.back() != ' ') key.push_back(' ');
+        } else {
+            key.push_back(static_cast<char>(tolower(u)));
+        }
+    }
+    if (!key.empty() && key.back() == ' ') key.pop_back();
+    return key;
+}
+
+// normalizeSearchText(text) == key, without building the string
+inline bool matchesSearchText(string_view text, string_view key) {
+    size_t k = 0;
+    bool space = false;
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (isspace(u)) {
+            space = k > 0;
+            continue;
+        }
+        if (space && (k >= key.size() || key[k++] != ' ')) return false;
+        space = false;
+        if (k >= key.size() || key[k++] != static_cast<char>(tolower(u))) return false;
+    }
+    return k == key.size();
+}
+
+// Bounded cache for findFlightByDestination, keyed by the normalized city so
+// "Mumbai", "mumbai" and " Mumbai" share an entry. The answer is one flight
+// (null for none) and depends on neither seat counts nor fares, so nothing
+// here is invalidated by bookings; only a new flight to a city that had none
+// drops an entry. Seat- and fare-dependent searches are not cached: the
+// price-range search stays on the lock-free snapshot path. Lookups may come
+// from several reader threads, hence the mutex, held only for the hash probe
+// and a reference-count increment.
+class QueryResultCache {
+public:
+    struct Key {
+        string city; // normalized
+
+        bool operator==(const Key& o) const { return city == o.city; }
+    };
+
+    static Key destinationKey(string_view city) { return Key{normalizeSearchText(city)}; }
+
+    explicit QueryResultCache(size_t capacity = 512) : entries(max<size_t>(capacity, 1)) {}
+
+    bool lookup(const Key& key, shared_ptr<Flight>& result) {
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            stats.misses++;
+            return false;
+        }
+        Entry& e = entries[it->second];
+        e.referenced = true;
+        result = e.result;
+        stats.hits++;
+        return true;
+    }
+
+    void store(const Key& key, const shared_ptr<Flight>& result) {
+        lock_guard<mutex> guard(lock);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            entries[it->second].result = result;
+            return;
+        }
+        // CLOCK: sweep past recently used entries, clearing their bit
+        while (entries[hand].used && entries[hand].referenced) {
+            entries[hand].referenced = false;
+            hand = (hand + 1) % entries.size();
+        }
+        Entry& victim = entries[hand];
+        if (victim.used) {
+            index.erase(victim.key);
+            stats.evictions++;
+        }
+        victim = Entry{key, result, true, false};
+        index.emplace(key, static_cast<uint32_t>(hand));
+        hand = (hand + 1) % entries.size();
+    }
+
+    // A flight was added: an entry for its city that found nothing is now wrong
+    void onFlightAdded(const Flight& flight) {
+        lock_guard<mutex> guard(lock);
+        for (Entry& e : entries) {
+            if (e.used && !e.result && matchesSearchText(flight.getArrivalCity(), e.key.city)) drop(e);
+        }
+    }
+
+    void clear() {
+        lock_guard<mutex> guard(lock);
+        for (Entry& e : entries) {
+            if (e.used) drop(e);
+        }
+    }
+
+    QueryCacheStats getStats() const {
+        lock_guard<mutex> guard(lock);
+        QueryCacheStats out = stats;
+        out.entries = index.size();
+        return out;
+    }
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& k) const { return static_cast<size_t>(hashString(k.city)); }
+    };
+
+    struct Entry {
+        Key key;
+        shared_ptr<Flight> result; // null: no flight to the city
+        bool used = false;
+        bool referenced = false;
+    };
+
+    void drop(Entry& e) {
+        index.erase(e.key);
+        e = Entry();
+        stats.invalidations++;
+    }
+
+    mutable mutex lock;
+    vector<Entry> entries;
+    unordered_map<Key, uint32_t, KeyHash> index;
+    size_t hand = 0;
+    QueryCacheStats stats;
+};
+
+// ============================================================================
+// FARE CALENDAR: lowest available fare per route and day
+// ============================================================================
+
+// Dense [route][day] array of the cheapest fare among flights with a free
+// seat, over a window of days (a year by default). Built from the query
+// engine's records with routes split across threads. After that a seat or
+// fare change touches only its own cell; the route's flights for that day
+// are rescanned only when the cheapest one sold out or got dearer.
+class FareCalendar {
+public:
+    static constexpr double NO_FARE = numeric_limits<double>::infinity();
+
+private:
+    static constexpr uint32_t NO_ROUTE = numeric_limits<uint32_t>::max();
+
+    const FlightQueryEngine& engine;
+    TimeMinutes firstDay = 0; // days since the epoch
+    int days = 0;
+    bool built = false;
+    unordered_map<uint64_t, uint32_t> routeIds; // (origin, destination) city IDs -> row
+    vector<uint64_t> routeKeys;                 // row -> (origin, destination)
+    vector<uint32_t> routeOfSlot;               // flight slot -> row
+    vector<double> fares;                       // row * days + day
+
+    static uint64_t routeKey(uint32_t origin, uint32_t destination) {
+        return (static_cast<uint64_t>(origin) << 32) | destination;
+    }
+
+    uint32_t internRoute(const FlightRecord& r) {
+        auto inserted = routeIds.emplace(routeKey(r.origin, r.destination), static_cast<uint32_t>(routeKeys.size()));
+        if (inserted.second) routeKeys.push_back(inserted.first->first);
+        return inserted.first->second;
+    }
+
+    // Day within the window, or -1 outside it
+    int dayIndex(const FlightRecord& r) const {
+        if (r.departure == INVALID_TIME) return -1;
+        TimeMinutes day = dayOf(r.departure) - firstDay;
+        return day >= 0 && day < days ? static_cast<int>(day) : -1;
+    }
+
+    void recomputeCell(uint32_t route, int day) {
+        const vector<uint32_t>& list =
+            engine.flightsOnRoute(static_cast<uint32_t>(routeKeys[route] >> 32), static_cast<uint32_t>(routeKeys[route]));
+        TimeMinutes from = (firstDay + day) * MINUTES_PER_DAY;
+        auto it = lower_bound(list.begin(), list.end(), from,
+                              [this](uint32_t s, TimeMinutes t) { return engine.record(s).departure < t; });
+        double best = NO_FARE;
+        for (; it != list.end() && engine.record(*it).departure < from + MINUTES_PER_DAY; ++it) {
+            const FlightRecord& r = engine.record(*it);
+            if (r.freeSeats > 0) best = min(best, r.price);
+        }
+        fares[size_t(route) * days + day] = best;
+    }
+
+public:
+    explicit FareCalendar(const FlightQueryEngine& e) : engine(e) {}
+
+    // Rebuilds the calendar for `windowDays` days from `startDay` (days since
+    // the epoch) and keeps it up to date from then on
+    void build(TimeMinutes startDay = 0, int windowDays = 365, unsigned threads = 0) {
+        firstDay = startDay;
+        days = max(windowDays, 1);
+        routeIds.clear();
+        routeKeys.clear();
+        routeOfSlot.assign(engine.size(), NO_ROUTE);
+        for (uint32_t slot = 0; slot < engine.size(); slot++) routeOfSlot[slot] = internRoute(engine.record(slot));
+        fares.assign(routeKeys.size() * days, NO_FARE);
+
+        // Each thread owns whole rows, so no cell is written by two threads
+        size_t routes = routeKeys.size();
+        unsigned parts = static_cast<unsigned>(
+            min<size_t>(threads ? threads : max(1u, thread::hardware_concurrency()), max<size_t>(routes, 1)));
+        auto fill = [this](size_t begin, size_t end) {
+            for (size_t route = begin; route < end; route++) {
+                for (uint32_t slot : engine.flightsOnRoute(static_cast<uint32_t>(routeKeys[route] >> 32),
+                                                           static_cast<uint32_t>(routeKeys[route]))) {
+                    const FlightRecord& r = engine.record(slot);
+                    int day = dayIndex(r);
+                    if (day < 0 || r.freeSeats <= 0) continue;
+                    double& cell = fares[route * days + day];
+                    cell = min(cell, r.price);
+                }
+            }
+        };
+        vector<thread> workers;
+        for (unsigned t = 1; t < parts; t++) workers.emplace_back(fill, routes * t / parts, routes * (t + 1) / parts);
+        fill(0, routes / parts);
+        for (auto& w : workers) w.join();
+        built = true;
+    }
+
+    // Call after the query engine has the flight
+    void addFlight(const Flight& flight) {
+        if (!built) return;
+        uint32_t slot = flight.getInventorySlot();
+        const FlightRecord& r = engine.record(slot);
+        if (routeOfSlot.size() <= slot) routeOfSlot.resize(slot + 1, NO_ROUTE);
+        routeOfSlot[slot] = internRoute(r);
+        if (fares.size() < routeKeys.size() * days) fares.resize(routeKeys.size() * days, NO_FARE);
+        int day = dayIndex(r);
+        if (day >= 0 && r.freeSeats > 0) {
+            double& cell = fares[size_t(routeOfSlot[slot]) * days + day];
+            cell = min(cell, r.price);
+        }
+    }
+
+    // Seats or fare of a flight changed (previousFare == current fare for
+    // seat changes). Call after the query engine's record is updated.
+    void update(const Flight& flight, double previousFare) {
+        uint32_t slot = flight.getInventorySlot();
+        if (!built || slot >= routeOfSlot.size()) return;
+        const FlightRecord& r = engine.record(slot);
+        int day = dayIndex(r);
+        if (day < 0) return;
+        uint32_t route = routeOfSlot[slot];
+        double& cell = fares[size_t(route) * days + day];
+        if (r.freeSeats > 0 && r.price <= cell) {
+            cell = r.price;
+        } else if (cell == previousFare || cell == r.price) {
+            recomputeCell(route, day); // this flight may have been the cheapest
+        }
+    }
+
+    // Lowest available fare on the route on `day` (days since the epoch);
+    // NO_FARE if nothing bookable flies that day or it is outside the window
+    double minFare(const string& origin, const string& destination, TimeMinutes day) const {
+        const double* row = routeRow(origin, destination);
+        TimeMinutes d = day - firstDay;
+        return row && d >= 0 && d < days ? row[d] : NO_FARE;
+    }
+
+    // The route's `windowDays()` cells, first day first, or null for an unknown route
+    const double* routeRow(const string& origin, const string& destination) const {
+        const CityDictionary& cities = engine.getCities();
+        uint32_t o = cities.lookup(origin), d = cities.lookup(destination);
+        if (!built || o == CityDictionary::UNKNOWN || d == CityDictionary::UNKNOWN) return nullptr;
+        auto it = routeIds.find(routeKey(o, d));
+        return it != routeIds.end() ? &fares[size_t(it->second) * days] : nullptr;
+    }
+
+    bool isBuilt() const { return built; }
+    TimeMinutes firstDayOfWindow() const { return firstDay; }
+    int windowDays() const { return days; }
+    size_t routeCount() const { return routeKeys.size(); }
+    size_t memoryBytes() const {
+        return fares.capacity() * sizeof(double) + routeKeys.capacity() * sizeof(uint64_t) +
+               routeOfSlot.capacity() * sizeof(uint32_t) + routeIds.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 16);
+    }
+};
+
+// ============================================================================
+// AUTOCOMPLETE: prefix trie with a trigram fallback for typos
+// ============================================================================
+
+// Completions for partial search-box input over city names and flight
+// numbers. Prefix matches come from a trie whose nodes cache their top-k
+// terms by weight (flights served), so a lookup is one walk down the prefix.
+// When nothing starts with the input, terms sharing the most trigrams with
+// it are returned instead, which catches misspellings. Matching is
+// case-insensitive and every word of a term is a prefix entry point
+// ("york" finds "New York").
+class AutocompleteIndex {
+public:
+    enum class Kind : uint8_t { City, FlightNumber };
+
+    struct Completion {
+        string text;
+        Kind kind;
+        uint32_t weight;
+        double score; // 1 for prefix matches, trigram similarity otherwise
+    };
+
+    struct Limits {
+        size_t maxTerms = 1 << 16;
+        size_t maxTermLength = 48;
+    };
+
+    static constexpr size_t TOP_K = 8;
+
+    AutocompleteIndex() : AutocompleteIndex(Limits()) {}
+    explicit AutocompleteIndex(const Limits& l) : limits(l) { nodes.emplace_back(); }
+
+    // Adds a term or bumps its weight; false once the limits are reached
+    bool addTerm(string_view text, Kind kind, uint32_t weight = 1) {
+        string key = normalizeSearchText(text);
+        if (key.empty() || key.size() > limits.maxTermLength) return false;
+        auto it = termIds.find(key);
+        if (it != termIds.end()) {
+            terms[it->second].weight += weight;
+            offerAlongPaths(it->second);
+            return true;
+        }
+        if (terms.size() >= limits.maxTerms) return false;
+
+        uint32_t id = static_cast<uint32_t>(terms.size());
+        terms.push_back(Term{string(text), key, kind, weight, 0});
+        termIds.emplace(key, id);
+        forEachTrigram(key, [&](uint32_t gram) {
+            vector<uint32_t>& postings = trigrams[gram];
+            if (postings.empty() || postings.back() != id) {
+                postings.push_back(id);
+                terms[id].gramCount++;
+            }
+        });
+        offerAlongPaths(id);
+        return true;
+    }
+
+    vector<Completion> complete(string_view input, size_t k = 5) const {
+        vector<Completion> out;
+        string key = normalizeSearchText(input);
+        k = min(k, TOP_K);
+        if (k == 0) return out;
+
+        uint32_t node = key.size() > limits.maxTermLength ? NONE : walk(key);
+        if (node != NONE) {
+            const Node& n = nodes[node];
+            for (uint8_t i = 0; i < n.topCount && out.size() < k; i++) {
+                const Term& t = terms[n.top[i]];
+                out.push_back(Completion{t.text, t.kind, t.weight, 1.0});
+            }
+        }
+        if (out.empty() && key.size() >= 2) fuzzyMatches(key, k, out);
+        return out;
+    }
+
+    size_t termCount() const { return terms.size(); }
+
+    // Approximate heap footprint from container capacities
+    size_t memoryBytes() const {
+        size_t bytes = nodes.capacity() * sizeof(Node) + terms.capacity() * sizeof(Term);
+        for (const Term& t : terms) bytes += t.text.capacity() + t.key.capacity();
+        bytes += termIds.bucket_count() * sizeof(void*) + termIds.size() * (sizeof(string) + 2 * sizeof(void*) + 8);
+        bytes += trigrams.bucket_count() * sizeof(void*);
+        for (const auto& entry : trigrams) {
+            bytes += sizeof(entry) + 2 * sizeof(void*) + entry.second.capacity() * sizeof(uint32_t);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr uint32_t NONE = numeric_limits<uint32_t>::max();
+
+    struct Term {
+        string text; // as first added
+        string key;  // normalized
+        Kind kind;
+        uint32_t weight;
+        uint16_t gramCount;
+    };
+
+    // First-child / next-sibling trie; top holds term ids, best first
+    struct Node {
+        uint32_t firstChild = NONE;
+        uint32_t nextSibling = NONE;
+        char label = 0;
+        uint8_t topCount = 0;
+        uint32_t top[TOP_K];
+    };
+
+    // Trigrams of "$$key$", packed into the low 24 bits
+    template <typename Fn>
+    static void forEachTrigram(const string& key, Fn&& fn) {
+        uint32_t gram = ('$' << 8) | '$';
+        for (size_t i = 0; i <= key.size(); i++) {
+            unsigned char c = i < key.size() ? static_cast<unsigned char>(key[i]) : '$';
+            gram = ((gram << 8) | c) & 0xFFFFFF;
+            fn(gram);
+        }
+    }
+
+    bool better(uint32_t a, uint32_t b) const {
+        if (terms[a].weight != terms[b].weight) return terms[a].weight > terms[b].weight;
+        return terms[a].key < terms[b].key;
+    }
+
+    uint32_t child(uint32_t node, char c) const {
+        for (uint32_t n = nodes[node].firstChild; n != NONE; n = nodes[n].nextSibling) {
+            if (nodes[n].label == c) return n;
+        }
+        return NONE;
+    }
+
+    uint32_t walk(const string& key) const {
+        uint32_t node = 0;
+        for (char c : key) {
+            node = child(node, c);
+            if (node == NONE) return NONE;
+        }
+        return node;
+    }
+
+    void offer(uint32_t node, uint32_t id) {
+        Node& n = nodes[node];
+        uint8_t pos = 0;
+        while (pos < n.topCount && n.top[pos] != id) pos++;
+        if (pos == n.topCount) {
+            if (n.topCount < TOP_K) {
+                n.topCount++;
+            } else if (better(id, n.top[TOP_K - 1])) {
+                pos = TOP_K - 1;
+            } else {
+                return;
+            }
+        }
+        // Weights only grow, so the term can only move towards the front
+        for (; pos > 0 && better(id, n.top[pos - 1]); pos--) n.top[pos] = n.top[pos - 1];
+        n.top[pos] = id;
+    }
+
+    // Every word start of the term is a path from the root
+    void offerAlongPaths(uint32_t id) {
+        const string key = terms[id].key;
+        offer(0, id);
+        for (size_t start = 0; start < key.size(); start++) {
+            if (start > 0 && key[start - 1] != ' ') continue;
+            uint32_t node = 0;
+            for (size_t i = start; i < key.size(); i++) {
+                uint32_t next = child(node, key[i]);
+                if (next == NONE) {
+                    next = static_cast<uint32_t>(nodes.size());
+                    nodes.emplace_back();
+                    nodes[next].label = key[i];
+                    nodes[next].nextSibling = nodes[node].firstChild;
+                    nodes[node].firstChild = next;
+                }
+                node = next;
+                offer(node, id);
+            }
+        }
+    }
+
+    // Scores terms by trigram Jaccard similarity and appends the best k
+    void fuzzyMatches(const string& key, size_t k, vector<Completion>& out) const {
+        thread_local vector<uint16_t> shared;
+        thread_local vector<uint32_t> touched;
+        if (shared.size() < terms.size()) shared.resize(terms.size(), 0);
+        touched.clear();
+
+        uint32_t queryGrams = 0;
+        forEachTrigram(key, [&](uint32_t gram) {
+            queryGrams++;
+            auto it = trigrams.find(gram);
+            if (it == trigrams.end()) return;
+            for (uint32_t id : it->second) {
+                if (shared[id]++ == 0) touched.push_back(id);
+            }
+        });
+
+        pair<double, uint32_t> best[TOP_K];
+        size_t bestCount = 0;
+        for (uint32_t id : touched) {
+            double common = shared[id];
+            shared[id] = 0;
+            double score = common / (queryGrams + terms[id].gramCount - common);
+            if (score < MIN_SIMILARITY) continue;
+            auto before = [&](const pair<double, uint32_t>& a, const pair<double, uint32_t>& b) {
+                return a.first != b.first ? a.first > b.first : better(a.second, b.second);
+            };
+            pair<double, uint32_t> candidate(score, id);
+            size_t pos = bestCount < k ? bestCount++ : k;
+            if (pos == k) {
+                if (!before(candidate, best[k - 1])) continue;
+                pos = k - 1;
+            }
+            for (; pos > 0 && before(candidate, best[pos - 1]); pos--) best[pos] = best[pos - 1];
+            best[pos] = candidate;
+        }
+        for (size_t i = 0; i < bestCount && out.size() < k; i++) {
+            const Term& t = terms[best[i].second];
+            out.push_back(Completion{t.text, t.kind, t.weight, best[i].first});
+        }
+    }
+
+    static constexpr double MIN_SIMILARITY = 0.2;
+
+    Limits limits;
+    vector<Term> terms;
+    unordered_map<string, uint32_t> termIds;
+    vector<Node> nodes; // nodes[0] is the root
+    unordered_map<uint32_t, vector<uint32_t>> trigrams;
+};
+
+// ============================================================================
+// BOOKING ARCHIVE: sealed bookings in a compressed columnar file
+// ============================================================================
+
+// LEB128 varints and zigzag signed encoding, shared by the archive and traces
+inline void putVarint(vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline void putVarintString(vector<uint8_t>& out, string_view text) {
+    putVarint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// Bounds-checked cursor over varint-encoded bytes
+struct VarintReader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t b = *p++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+
+    string_view bytes(size_t n) {
+        n = min<size_t>(n, end - p);
+        string_view out(reinterpret_cast<const char*>(p), n);
+        p += n;
+        return out;
+    }
+
+    string_view text() { return bytes(varint()); }
+};
+
+// Append-only file of segments, one per sealing run. Each segment holds
+// dictionaries (cities, flights, passports) and one column per field:
+//   id         ascending, first value then deltas, LEB128 varints
+//   flight     dictionary index, varint
+//   passenger  dictionary index, varint
+//   class      one byte
+//   price      cents, zigzag varint of the delta to the previous row
+// Scans decode only the columns a query needs. Integers are host byte order,
+// as in the wire protocol.
+class BookingArchive {
+public:
+    struct FlightEntry {
+        string flightNumber;
+        uint32_t origin;      // city dictionary index
+        uint32_t destination; // city dictionary index
+        TimeMinutes departure;
+    };
+
+    // One sealed segment; columns stay encoded until asked for
+    class Segment {
+    private:
+        friend class BookingArchive;
+        uint32_t rows = 0;
+        vector<uint8_t> payload;
+        size_t columns[5][2] = {}; // (offset, length) per column
+
+        VarintReader column(int c) const {
+            const uint8_t* base = payload.data() + columns[c][0];
+            return VarintReader{base, base + columns[c][1]};
+        }
+
+        // Every dictionary entry and every column value takes at least one byte
+        static bool fits(const VarintReader& r, uint64_t n) { return n <= static_cast<uint64_t>(r.end - r.p); }
+
+        bool indexesBelow(int c, size_t limit) const {
+            VarintReader r = column(c);
+            for (uint32_t i = 0; i < rows; i++) {
+                if (r.varint() >= limit) return false;
+            }
+            return true;
+        }
+
+        // Rejects segments whose decoders would read past a column or index
+        // past a dictionary, so the queries can skip per-row checks
+        bool parse() {
+            VarintReader r{payload.data(), payload.data() + payload.size()};
+            uint64_t n = r.varint();
+            if (!fits(r, n)) return false;
+            for (uint64_t i = 0; i < n; i++) cities.emplace_back(r.bytes(r.varint()));
+            n = r.varint();
+            if (!fits(r, n)) return false;
+            for (uint64_t i = 0; i < n; i++) {
+                FlightEntry f;
+                f.flightNumber = string(r.bytes(r.varint()));
+                f.origin = static_cast<uint32_t>(r.varint());
+                f.destination = static_cast<uint32_t>(r.varint());
+                f.departure = static_cast<TimeMinutes>(unzigzag(r.varint()));
+                if (f.origin >= cities.size() || f.destination >= cities.size()) return false;
+                flights.push_back(move(f));
+            }
+            n = r.varint();
+            if (!fits(r, n)) return false;
+            for (uint64_t i = 0; i < n; i++) passports.emplace_back(r.bytes(r.varint()));
+            for (auto& c : columns) {
+                c[1] = r.varint();
+                c[0] = r.p - payload.data();
+                if (c[1] > static_cast<size_t>(r.end - r.p) || c[1] < rows) return false;
+                r.p += c[1];
+            }
+            VarintReader classes = column(Class);
+            for (uint32_t i = 0; i < rows; i++) {
+                if (classes.p[i] > static_cast<uint8_t>(SeatClass::First)) return false;
+            }
+            return indexesBelow(FlightIndex, flights.size()) && indexesBelow(PassengerIndex, passports.size());
+        }
+
+    public:
+        enum Column { Id, FlightIndex, PassengerIndex, Class, Price };
+
+        vector<string> cities;
+        vector<FlightEntry> flights;
+        vector<string> passports;
+
+        uint32_t rowCount() const { return rows; }
+
+        void decodeIds(vector<BookingId>& out) const {
+            VarintReader r = column(Id);
+            out.resize(rows);
+            BookingId prev = 0;
+            for (uint32_t i = 0; i < rows; i++) out[i] = prev += r.varint();
+        }
+
+        void decodeFlights(vector<uint32_t>& out) const { decodeIndexes(FlightIndex, out); }
+        void decodePassengers(vector<uint32_t>& out) const { decodeIndexes(PassengerIndex, out); }
+
+        void decodeClasses(vector<SeatClass>& out) const {
+            VarintReader r = column(Class);
+            out.resize(rows);
+            for (uint32_t i = 0; i < rows; i++) out[i] = static_cast<SeatClass>(r.p[i]);
+        }
+
+        void decodePrices(vector<double>& out) const {
+            VarintReader r = column(Price);
+            out.resize(rows);
+            int64_t cents = 0;
+            for (uint32_t i = 0; i < rows; i++) {
+                cents += unzigzag(r.varint());
+                out[i] = cents / 100.0;
+            }
+        }
+
+    private:
+        void decodeIndexes(Column c, vector<uint32_t>& out) const {
+            VarintReader r = column(c);
+            out.resize(rows);
+            for (uint32_t i = 0; i < rows; i++) out[i] = static_cast<uint32_t>(r.varint());
+        }
+    };
+
+    explicit BookingArchive(string filePath) : path(move(filePath)) {}
+
+    // Appends the bookings as one segment; returns false on I/O error
+    bool seal(vector<shared_ptr<Booking>> rows) {
+        if (rows.empty()) return true;
+        sort(rows.begin(), rows.end(), [](const shared_ptr<Booking>& a, const shared_ptr<Booking>& b) {
+            return a->getBookingId() < b->getBookingId();
+        });
+
+        unordered_map<string, uint32_t> cityIds, flightIds, passportIds;
+        vector<uint8_t> dictCities, dictFlights, dictPassports, cols[5];
+        auto intern = [](unordered_map<string, uint32_t>& ids, const string& key, bool& added) {
+            auto it = ids.emplace(key, static_cast<uint32_t>(ids.size()));
+            added = it.second;
+            return it.first->second;
+        };
+
+        BookingId prevId = 0;
+        int64_t prevCents = 0;
+        for (const auto& booking : rows) {
+            const Flight& flight = *booking->getFlight();
+            bool added;
+            uint32_t flightId = intern(flightIds, flight.getFlightNumber(), added);
+            if (added) {
+                uint32_t origin = intern(cityIds, flight.getDepartureCity(), added);
+                if (added) putVarintString(dictCities, flight.getDepartureCity());
+                uint32_t destination = intern(cityIds, flight.getArrivalCity(), added);
+                if (added) putVarintString(dictCities, flight.getArrivalCity());
+                putVarintString(dictFlights, flight.getFlightNumber());
+                putVarint(dictFlights, origin);
+                putVarint(dictFlights, destination);
+                putVarint(dictFlights, zigzag(flight.getDepartureMinutes()));
+            }
+            string passport(booking->getPassenger()->getPassport());
+            uint32_t passengerId = intern(passportIds, passport, added);
+            if (added) putVarintString(dictPassports, passport);
+
+            int64_t cents = llround(booking->getTotalPrice() * 100.0);
+            putVarint(cols[Segment::Id], booking->getBookingId() - prevId);
+            putVarint(cols[Segment::FlightIndex], flightId);
+            putVarint(cols[Segment::PassengerIndex], passengerId);
+            cols[Segment::Class].push_back(static_cast<uint8_t>(booking->getSeatClass()));
+            putVarint(cols[Segment::Price], zigzag(cents - prevCents));
+            prevId = booking->getBookingId();
+            prevCents = cents;
+        }
+
+        vector<uint8_t> payload;
+        putVarint(payload, cityIds.size());
+        payload.insert(payload.end(), dictCities.begin(), dictCities.end());
+        putVarint(payload, flightIds.size());
+        payload.insert(payload.end(), dictFlights.begin(), dictFlights.end());
+        putVarint(payload, passportIds.size());
+        payload.insert(payload.end(), dictPassports.begin(), dictPassports.end());
+        for (const auto& c : cols) {
+            putVarint(payload, c.size());
+            payload.insert(payload.end(), c.begin(), c.end());
+        }
+
+        FILE* file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+        uint32_t header[2] = {SEGMENT_MAGIC, static_cast<uint32_t>(rows.size())};
+        uint64_t size = payload.size();
+        bool ok = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(&size, sizeof(size), 1, file) == 1 &&
+                  fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+        return fclose(file) == 0 && ok;
+    }
+
+    // Calls fn(const Segment&) for each segment in file order; false on a corrupt file
+    template <typename Fn>
+    bool scan(Fn&& fn) const {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return true; // nothing sealed yet
+        fseek(file, 0, SEEK_END);
+        long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        bool ok = fileSize >= 0;
+        uint32_t header[2];
+        uint64_t size;
+        while (ok && fread(header, sizeof(header), 1, file) == 1) {
+            Segment segment;
+            // The payload size comes from the file: check it before allocating
+            if (header[0] != SEGMENT_MAGIC || fread(&size, sizeof(size), 1, file) != 1 ||
+                size > static_cast<uint64_t>(fileSize - ftell(file))) {
+                ok = false;
+                break;
+            }
+            segment.rows = header[1];
+            segment.payload.resize(size);
+            if (fread(segment.payload.data(), 1, size, file) != size || !segment.parse()) {
+                ok = false;
+                break;
+            }
+            fn(static_cast<const Segment&>(segment));
+        }
+        fclose(file);
+        return ok;
+    }
+
+    // Revenue queries; each decodes only the columns it reads and returns
+    // false on a corrupt file (the result then covers only the segments
+    // before the damage)
+
+    bool totalRevenue(double& total) const {
+        total = 0.0;
+        vector<double> prices;
+        return scan([&](const Segment& seg) {
+            seg.decodePrices(prices);
+            for (double p : prices) total += p;
+        });
+    }
+
+    // (origin, destination) -> revenue
+    bool revenueByRoute(map<pair<string, string>, double>& totals) const {
+        totals.clear();
+        vector<double> prices;
+        vector<uint32_t> flightIndexes;
+        return scan([&](const Segment& seg) {
+            seg.decodePrices(prices);
+            seg.decodeFlights(flightIndexes);
+            vector<double> perFlight(seg.flights.size(), 0.0);
+            for (uint32_t i = 0; i < seg.rowCount(); i++) perFlight[flightIndexes[i]] += prices[i];
+            for (size_t f = 0; f < perFlight.size(); f++) {
+                totals[{seg.cities[seg.flights[f].origin], seg.cities[seg.flights[f].destination]}] += perFlight[f];
+            }
+        });
+    }
+
+    // Revenue of flights departing in [from, to]
+    bool revenueBetween(TimeMinutes from, TimeMinutes to, double& total) const {
+        total = 0.0;
+        vector<double> prices;
+        vector<uint32_t> flightIndexes;
+        return scan([&](const Segment& seg) {
+            seg.decodePrices(prices);
+            seg.decodeFlights(flightIndexes);
+            for (uint32_t i = 0; i < seg.rowCount(); i++) {
+                TimeMinutes dep = seg.flights[flightIndexes[i]].departure;
+                if (dep >= from && dep <= to) total += prices[i];
+            }
+        });
+    }
+
+    bool rowCount(size_t& rows) const {
+        rows = 0;
+        return scan([&](const Segment& seg) { rows += seg.rowCount(); });
+    }
+
+    size_t fileBytes() const {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return 0;
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fclose(file);
+        return size > 0 ? static_cast<size_t>(size) : 0;
+    }
+
+    const string& getPath() const { return path; }
+
+private:
+    static constexpr uint32_t SEGMENT_MAGIC = 0x47455346; // "FSEG"
+
+    string path;
+
+};
+
+// ============================================================================
+// TRACE RECORDING: compact binary log of API calls for offline replay
+// ============================================================================
+
+enum class TraceOp : uint8_t {
+    AddFlight = 1,
+    DefinePassenger,
+    CreateBooking,
+    ConfirmOrWaitlist,
+    CancelBooking,
+    FindFlightByDestination,
+    FindFlightsByPriceRange,
+    FindCheapestFlight,
+    Query,
+    FindFlightsDepartingBetween,
+    FindCheapestRoute,
+    ConfirmReservedSeat,
+    HoldSeat,
+    ConfirmHeldSeat,
+    ReleaseHeldSeat,
+    AssignSeat,
+    SetFare,
+    Count
+};
+
+inline const char* traceOpName(TraceOp op) {
+    static const char* names[] = {"", "addFlight", "definePassenger", "createBooking", "confirmOrWaitlist",
+                                  "cancelBooking", "findFlightByDestination", "findFlightsByPriceRange",
+                                  "findCheapestFlight", "query", "findFlightsDepartingBetween", "findCheapestRoute",
+                                  "confirmReservedSeat", "holdSeat", "confirmHeldSeat", "releaseHeldSeat",
+                                  "assignSeat", "setFare"};
+    return names[static_cast<size_t>(op)];
+}
+
+// Trace file: "FBSTRACE", then records of
+//   op (1 byte), nanoseconds since the previous record (varint), arguments.
+// Flights are referred to by the order they were added, passengers by the
+// order they first appeared and bookings by the order they were created, so
+// a replay maps them onto its own objects and IDs. Records are buffered and
+// written in 64 KB blocks; the recorder is not thread-safe (like the system).
+// Every system call that changes seats, bookings or fares is recorded, so
+// traces taken under the batched service or the booking workflow replay to
+// the same state. A confirmReservedSeat replays as taking one seat from the
+// flight first. Changes made on a Flight directly (bookSeats / releaseSeat
+// outside the system) or by archiving are not seen and do not replay.
+class TraceRecorder {
+private:
+    static constexpr size_t FLUSH_BYTES = 1 << 16;
+    static constexpr uint64_t NONE = 0; // ordinals are stored +1
+
+    FILE* file;
+    vector<uint8_t> buffer;
+    chrono::steady_clock::time_point last;
+    uint64_t records = 0;
+    uint64_t bytesWritten = 0;
+
+    unordered_map<string, uint32_t> flightOrdinals;
+    unordered_map<string, uint32_t> passengerOrdinals; // by passport
+    unordered_map<BookingId, uint32_t> bookingOrdinals;
+    uint32_t bookingCount = 0;
+
+    explicit TraceRecorder(FILE* f) : file(f), last(chrono::steady_clock::now()) {
+        buffer.reserve(FLUSH_BYTES * 2);
+        buffer.insert(buffer.end(), MAGIC, MAGIC + 8);
+    }
+
+    void begin(TraceOp op) {
+        auto now = chrono::steady_clock::now();
+        buffer.push_back(static_cast<uint8_t>(op));
+        putVarint(buffer, static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(now - last).count()));
+        last = now;
+        records++;
+    }
+
+    void end() {
+        if (buffer.size() >= FLUSH_BYTES) flush();
+    }
+
+    void putDouble(double v) {
+        uint8_t raw[sizeof(double)];
+        memcpy(raw, &v, sizeof(v));
+        buffer.insert(buffer.end(), raw, raw + sizeof(raw));
+    }
+
+    void putTime(TimeMinutes t) { putVarint(buffer, zigzag(t)); }
+
+    void putFlight(string_view flightNumber) {
+        auto it = flightOrdinals.find(string(flightNumber));
+        putVarint(buffer, it != flightOrdinals.end() ? it->second + 1 : NONE);
+        if (it == flightOrdinals.end()) putVarintString(buffer, flightNumber);
+    }
+
+    void putBooking(BookingId id) {
+        auto it = bookingOrdinals.find(id);
+        putVarint(buffer, it != bookingOrdinals.end() ? it->second + 1 : NONE);
+    }
+
+public:
+    static constexpr char MAGIC[9] = "FBSTRACE";
+
+    // Null if the file cannot be created
+    static unique_ptr<TraceRecorder> open(const string& path) {
+        FILE* f = fopen(path.c_str(), "wb");
+        return f ? unique_ptr<TraceRecorder>(new TraceRecorder(f)) : nullptr;
+    }
+
+    ~TraceRecorder() {
+        flush();
+        fclose(file);
+    }
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    void flush() {
+        if (buffer.empty()) return;
+        bytesWritten += fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+        fflush(file);
+    }
+
+    void addFlight(const Flight& flight) {
+        begin(TraceOp::AddFlight);
+        putVarintString(buffer, flight.getFlightType());
+        putVarintString(buffer, flight.getFlightNumber());
+        putVarintString(buffer, flight.getDepartureCity());
+        putVarintString(buffer, flight.getArrivalCity());
+        putTime(flight.getDepartureMinutes());
+        putTime(flight.getArrivalMinutes());
+        putVarint(buffer, static_cast<uint64_t>(flight.getTotalSeats()));
+        flightOrdinals.emplace(flight.getFlightNumber(), static_cast<uint32_t>(flightOrdinals.size()));
+        end();
+    }
+
+    // result is the new booking's ID, or 0 if the flight was not found
+    void createBooking(const Passenger& passenger, string_view flightNumber, SeatClass seatClass, BookingId result) {
+        string passport(passenger.getPassport());
+        auto it = passengerOrdinals.find(passport);
+        if (it == passengerOrdinals.end()) {
+            begin(TraceOp::DefinePassenger);
+            putVarintString(buffer, passenger.getName());
+            putVarintString(buffer, passport);
+            putVarintString(buffer, passenger.getContact());
+            putVarintString(buffer, passenger.getEmail());
+            it = passengerOrdinals.emplace(passport, static_cast<uint32_t>(passengerOrdinals.size())).first;
+        }
+        begin(TraceOp::CreateBooking);
+        putVarint(buffer, it->second);
+        putFlight(flightNumber);
+        buffer.push_back(static_cast<uint8_t>(seatClass));
+        // Every create gets an ordinal, so replays stay aligned even when it failed
+        if (result) bookingOrdinals.emplace(result, bookingCount);
+        bookingCount++;
+        end();
+    }
+
+    void confirmOrWaitlist(BookingId id) {
+        begin(TraceOp::ConfirmOrWaitlist);
+        putBooking(id);
+        end();
+    }
+
+    void cancelBooking(BookingId id) {
+        begin(TraceOp::CancelBooking);
+        putBooking(id);
+        end();
+    }
+
+    // confirmReservedSeat, holdSeat, confirmHeldSeat, releaseHeldSeat
+    void bookingCall(TraceOp op, BookingId id) {
+        begin(op);
+        putBooking(id);
+        end();
+    }
+
+    void assignSeat(BookingId id, SeatPreference pref) {
+        begin(TraceOp::AssignSeat);
+        putBooking(id);
+        buffer.push_back(static_cast<uint8_t>(pref));
+        end();
+    }
+
+    void setFare(string_view flightNumber, double fare) {
+        begin(TraceOp::SetFare);
+        putFlight(flightNumber);
+        putDouble(fare);
+        end();
+    }
+
+    void findFlightByDestination(const string& destination) {
+        begin(TraceOp::FindFlightByDestination);
+        putVarintString(buffer, destination);
+        end();
+    }
+
+    void findFlightsByPriceRange(double minPrice, double maxPrice) {
+        begin(TraceOp::FindFlightsByPriceRange);
+        putDouble(minPrice);
+        putDouble(maxPrice);
+        end();
+    }
+
+    void findCheapestFlight(double maxPrice) {
+        begin(TraceOp::FindCheapestFlight);
+        putDouble(maxPrice);
+        end();
+    }
+
+    void query(const FlightQuery& q) {
+        begin(TraceOp::Query);
+        putVarintString(buffer, q.origin);
+        putVarintString(buffer, q.destination);
+        putTime(q.departAfter);
+        putTime(q.departBefore);
+        putDouble(q.minPrice);
+        putDouble(q.maxPrice);
+        putVarint(buffer, zigzag(q.minFreeSeats));
+        end();
+    }
+
+    void findFlightsDepartingBetween(const string& origin, TimeMinutes from, TimeMinutes to) {
+        begin(TraceOp::FindFlightsDepartingBetween);
+        putVarintString(buffer, origin);
+        putTime(from);
+        putTime(to);
+        end();
+    }
+
+    void findCheapestRoute(const string& from, const string& to) {
+        begin(TraceOp::FindCheapestRoute);
+        putVarintString(buffer, from);
+        putVarintString(buffer, to);
+        end();
+    }
+
+    uint64_t recordCount() const { return records; }
+    uint64_t bytes() const { return bytesWritten + buffer.size(); }
+};
+
+// ============================================================================
+// FLEET SEAT INDEX: roaring bitmaps of per-flight seat attributes
+// ============================================================================
+
+// Compressed set of uint32 values (flight slots), split by the high 16 bits
+// into containers that are either a sorted uint16 array (sparse) or a
+// 65536-bit bitmap (dense), switching at 4096 values as in Roaring.
+class RoaringBitmap {
+private:
+    static constexpr size_t ARRAY_MAX = 4096;
+    static constexpr size_t WORDS = 1024;
+
+    struct Container {
+        vector<uint16_t> array; // used while bits is empty
+        vector<uint64_t> bits;
+        uint32_t cardinality = 0;
+
+        bool isBitmap() const { return !bits.empty(); }
+
+        bool contains(uint16_t v) const {
+            if (isBitmap()) return bits[v >> 6] >> (v & 63) & 1;
+            return binary_search(array.begin(), array.end(), v);
+        }
+
+        bool add(uint16_t v) {
+            if (isBitmap()) {
+                uint64_t& w = bits[v >> 6];
+                uint64_t mask = uint64_t(1) << (v & 63);
+                if (w & mask) return false;
+                w |= mask;
+            } else {
+                auto it = lower_bound(array.begin(), array.end(), v);
+                if (it != array.end() && *it == v) return false;
+                array.insert(it, v);
+            }
+            cardinality++;
+            normalize();
+            return true;
+        }
+
+        bool remove(uint16_t v) {
+            if (isBitmap()) {
+                uint64_t& w = bits[v >> 6];
+                uint64_t mask = uint64_t(1) << (v & 63);
+                if (!(w & mask)) return false;
+                w &= ~mask;
+            } else {
+                auto it = lower_bound(array.begin(), array.end(), v);
+                if (it == array.end() || *it != v) return false;
+                array.erase(it);
+            }
+            cardinality--;
+            normalize();
+            return true;
+        }
+
+        // Array while small, bitmap once it would be larger than 8 KB
+        void normalize() {
+            if (!isBitmap() && cardinality > ARRAY_MAX) {
+                bits.assign(WORDS, 0);
+                for (uint16_t v : array) bits[v >> 6] |= uint64_t(1) << (v & 63);
+                vector<uint16_t>().swap(array);
+            } else if (isBitmap() && cardinality <= ARRAY_MAX) {
+                array.clear();
+                array.reserve(cardinality);
+                for (size_t w = 0; w < WORDS; w++) {
+                    for (uint64_t word = bits[w]; word; word &= word - 1) {
+                        array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+                    }
+                }
+                vector<uint64_t>().swap(bits);
+            }
+        }
+
+        template <typename Fn>
+        void forEach(uint32_t high, Fn&& fn) const {
+            if (isBitmap()) {
+                for (size_t w = 0; w < WORDS; w++) {
+                    for (uint64_t word = bits[w]; word; word &= word - 1) fn(high | uint32_t(w * 64 + __builtin_ctzll(word)));
+                }
+            } else {
+                for (uint16_t v : array) fn(high | v);
+            }
+        }
+
+        static Container intersect(const Container& a, const Container& b) {
+            Container out;
+            if (a.isBitmap() && b.isBitmap()) {
+                out.bits.resize(WORDS);
+                for (size_t w = 0; w < WORDS; w++) {
+                    out.bits[w] = a.bits[w] & b.bits[w];
+                    out.cardinality += __builtin_popcountll(out.bits[w]);
+                }
+            } else if (a.isBitmap() || b.isBitmap()) {
+                const Container& arr = a.isBitmap() ? b : a;
+                const Container& bmp = a.isBitmap() ? a : b;
+                for (uint16_t v : arr.array) {
+                    if (bmp.contains(v)) out.array.push_back(v);
+                }
+                out.cardinality = static_cast<uint32_t>(out.array.size());
+            } else {
+                set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                 back_inserter(out.array));
+                out.cardinality = static_cast<uint32_t>(out.array.size());
+            }
+            out.normalize();
+            return out;
+        }
+
+        static Container unite(const Container& a, const Container& b) {
+            Container out;
+            if (a.isBitmap() || b.isBitmap()) {
+                out.bits.assign(WORDS, 0);
+                for (const Container* c : {&a, &b}) {
+                    if (c->isBitmap()) {
+                        for (size_t w = 0; w < WORDS; w++) out.bits[w] |= c->bits[w];
+                    } else {
+                        for (uint16_t v : c->array) out.bits[v >> 6] |= uint64_t(1) << (v & 63);
+                    }
+                }
+                for (uint64_t w : out.bits) out.cardinality += __builtin_popcountll(w);
+            } else {
+                set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), back_inserter(out.array));
+                out.cardinality = static_cast<uint32_t>(out.array.size());
+            }
+            out.normalize();
+            return out;
+        }
+    };
+
+    vector<uint16_t> keys; // sorted high halves
+    vector<Container> containers;
+
+    size_t find(uint16_t key) const {
+        return lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+public:
+    bool contains(uint32_t v) const {
+        size_t i = find(static_cast<uint16_t>(v >> 16));
+        return i < keys.size() && keys[i] == (v >> 16) && containers[i].contains(static_cast<uint16_t>(v));
+    }
+
+    bool add(uint32_t v) {
+        uint16_t key = static_cast<uint16_t>(v >> 16);
+        size_t i = find(key);
+        if (i == keys.size() || keys[i] != key) {
+            keys.insert(keys.begin() + i, key);
+            containers.insert(containers.begin() + i, Container());
+        }
+        return containers[i].add(static_cast<uint16_t>(v));
+    }
+
+    bool remove(uint32_t v) {
+        uint16_t key = static_cast<uint16_t>(v >> 16);
+        size_t i = find(key);
+        if (i == keys.size() || keys[i] != key || !containers[i].remove(static_cast<uint16_t>(v))) return false;
+        if (containers[i].cardinality == 0) {
+            keys.erase(keys.begin() + i);
+            containers.erase(containers.begin() + i);
+        }
+        return true;
+    }
+
+    void set(uint32_t v, bool present) {
+        if (present) {
+            add(v);
+        } else {
+            remove(v);
+        }
+    }
+
+    RoaringBitmap operator&(const RoaringBitmap& o) const {
+        RoaringBitmap out;
+        for (size_t i = 0, j = 0; i < keys.size() && j < o.keys.size();) {
+            if (keys[i] < o.keys[j]) {
+                i++;
+            } else if (o.keys[j] < keys[i]) {
+                j++;
+            } else {
+                Container c = Container::intersect(containers[i], o.containers[j]);
+                if (c.cardinality) {
+                    out.keys.push_back(keys[i]);
+                    out.containers.push_back(move(c));
+                }
+                i++, j++;
+            }
+        }
+        return out;
+    }
+
+    RoaringBitmap operator|(const RoaringBitmap& o) const {
+        RoaringBitmap out;
+        size_t i = 0, j = 0;
+        while (i < keys.size() || j < o.keys.size()) {
+            if (j == o.keys.size() || (i < keys.size() && keys[i] < o.keys[j])) {
+                out.keys.push_back(keys[i]);
+                out.containers.push_back(containers[i++]);
+            } else if (i == keys.size() || o.keys[j] < keys[i]) {
+                out.keys.push_back(o.keys[j]);
+                out.containers.push_back(o.containers[j++]);
+            } else {
+                out.keys.push_back(keys[i]);
+                out.containers.push_back(Container::unite(containers[i++], o.containers[j++]));
+            }
+        }
+        return out;
+    }
+
+    size_t cardinality() const {
+        size_t n = 0;
+        for (const auto& c : containers) n += c.cardinality;
+        return n;
+    }
+
+    bool empty() const { return keys.empty(); }
+
+    // fn(uint32_t) in ascending order
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < keys.size(); i++) containers[i].forEach(uint32_t(keys[i]) << 16, fn);
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = keys.capacity() * sizeof(uint16_t) + containers.capacity() * sizeof(Container);
+        for (const auto& c : containers) bytes += c.array.capacity() * sizeof(uint16_t) + c.bits.capacity() * sizeof(uint64_t);
+        return bytes;
+    }
+};
+
+// Seat maps for the whole fleet plus one RoaringBitmap of flight slots per
+// (seat class, attribute). Cabins are 3-3 (domestic, 6 across) or 3-3-3
+// (international, 9 across); First rows come first, then Business, then
+// Economy. Each claim or release rescans only the seat's row and flips the
+// flight's bit in the bitmaps whose threshold it crosses, so fleet-wide
+// questions are a few ANDs / ORs instead of one seat-map walk per flight.
+// Bookings take seats before (or without) seat selection, so each class also
+// counts its sales: a class is only as free as its unsold seats, and drops
+// out of every bitmap once sold out, whether or not seats were picked.
+class FleetSeatIndex {
+public:
+    enum class Attribute { FreeAisle, FreeWindow, AdjacentPair, WindowPair, Count };
+
+    static constexpr size_t CLASS_COUNT = 3;
+    static constexpr size_t ATTRIBUTE_COUNT = static_cast<size_t>(Attribute::Count);
+    static constexpr int FREE_LEVELS = 6; // bitmaps for >= 1, 2, 4, ... 32 free seats per class
+
+private:
+    // Free-seat counters of one cabin class on one flight
+    struct ClassCounts {
+        int32_t free = 0;
+        int32_t attributes[ATTRIBUTE_COUNT] = {};
+    };
+
+    struct SeatMap {
+        int width = 6;
+        int rows = 0;
+        int totalSeats = 0;
+        int classEnd[CLASS_COUNT] = {}; // First rows < classEnd[0] <= Business rows < classEnd[1] <= Economy
+        vector<uint64_t> occupied;      // seat = row * width + col; padding seats stay occupied
+        ClassCounts counts[CLASS_COUNT];
+        int32_t classSeats[CLASS_COUNT] = {}; // real seats per class
+        int32_t sold[CLASS_COUNT] = {};       // bookings holding a seat in the class, seat picked or not
+
+        // Free on the map and not promised to a booking still without a seat
+        int32_t forSale(size_t c) const { return max(0, min(counts[c].free, classSeats[c] - sold[c])); }
+
+        bool isOccupied(int seat) const { return occupied[seat >> 6] >> (seat & 63) & 1; }
+        void flip(int seat) { occupied[seat >> 6] ^= uint64_t(1) << (seat & 63); }
+
+        int classOfRow(int row) const {
+            return row < classEnd[0] ? int(SeatClass::First) : row < classEnd[1] ? int(SeatClass::Business)
+                                                                                  : int(SeatClass::Economy);
+        }
+        bool isWindow(int col) const { return col == 0 || col == width - 1; }
+        bool isAisle(int col) const { return col % 3 == 2 ? col + 1 < width : col % 3 == 0 && col > 0; }
+        // Neighbours across an aisle are not adjacent
+        bool adjacent(int col) const { return col + 1 < width && (col + 1) % 3 != 0; }
+
+        // Adds (sign 1) or removes (sign -1) one row's contribution to the counters
+        void countRow(int row, int sign) {
+            ClassCounts& c = counts[classOfRow(row)];
+            int base = row * width;
+            for (int col = 0; col < width; col++) {
+                if (isOccupied(base + col)) continue;
+                c.free += sign;
+                if (isAisle(col)) c.attributes[int(Attribute::FreeAisle)] += sign;
+                if (isWindow(col)) c.attributes[int(Attribute::FreeWindow)] += sign;
+                if (adjacent(col) && !isOccupied(base + col + 1)) {
+                    c.attributes[int(Attribute::AdjacentPair)] += sign;
+                    if (isWindow(col) || isWindow(col + 1)) c.attributes[int(Attribute::WindowPair)] += sign;
+                }
+            }
+        }
+    };
+
+    vector<SeatMap> maps; // by flight inventory slot
+    vector<uint8_t> bookable; // seat count not sold out
+    RoaringBitmap attributeBits[CLASS_COUNT][ATTRIBUTE_COUNT];
+    RoaringBitmap freeBits[CLASS_COUNT][FREE_LEVELS];
+    // Static flight properties, so schedule filters combine with seat attributes
+    unordered_map<string, RoaringBitmap> byOrigin;
+    unordered_map<TimeMinutes, RoaringBitmap> byDay;
+    RoaringBitmap none;
+
+    void refreshBitmaps(uint32_t slot, size_t c) {
+        const SeatMap& m = maps[slot];
+        int32_t free = bookable[slot] ? m.forSale(c) : 0;
+        for (size_t a = 0; a < ATTRIBUTE_COUNT; a++) attributeBits[c][a].set(slot, free > 0 && m.counts[c].attributes[a] > 0);
+        for (int level = 0; level < FREE_LEVELS; level++) freeBits[c][level].set(slot, free >= (1 << level));
+    }
+
+    void refreshBitmaps(uint32_t slot) {
+        for (size_t c = 0; c < CLASS_COUNT; c++) refreshBitmaps(slot, c);
+    }
+
+    // Claims a free seat or frees a claimed one
+    void toggleSeat(uint32_t slot, int seat) {
+        SeatMap& m = maps[slot];
+        int row = seat / m.width;
+        m.countRow(row, -1);
+        m.flip(seat);
+        m.countRow(row, +1);
+        refreshBitmaps(slot, m.classOfRow(row));
+    }
+
+public:
+    // Refuses (false) a seat count outside 1..Flight::MAX_SEATS: the slot then
+    // keeps an empty seat map and stays out of every bitmap
+    bool addFlight(const Flight& flight) {
+        uint32_t slot = flight.getInventorySlot();
+        if (maps.size() <= slot) {
+            maps.resize(slot + 1);
+            bookable.resize(slot + 1, 0);
+        }
+        if (!Flight::isValidSeatCount(flight.getTotalSeats())) return false;
+        SeatMap& m = maps[slot];
+        bool international = flight.getFlightType() == "International";
+        m.width = international ? 9 : 6;
+        m.totalSeats = flight.getTotalSeats();
+        m.rows = (m.totalSeats + m.width - 1) / m.width;
+        int firstRows = international ? max(1, m.rows / 20) : 0;
+        int businessRows = max(1, m.rows / (international ? 8 : 10));
+        m.classEnd[0] = min(m.rows, firstRows);
+        m.classEnd[1] = min(m.rows, firstRows + businessRows);
+        m.occupied.assign((m.rows * m.width + 63) / 64, 0);
+        for (int seat = m.totalSeats; seat < m.rows * m.width; seat++) m.flip(seat);
+        for (int row = 0; row < m.rows; row++) m.countRow(row, +1);
+        for (size_t c = 0; c < CLASS_COUNT; c++) m.classSeats[c] = m.counts[c].free;
+        bookable[slot] = flight.getAvailableSeats() > 0;
+        refreshBitmaps(slot);
+        byOrigin[flight.getDepartureCity()].add(slot);
+        byDay[dayOf(flight.getDepartureMinutes())].add(slot);
+        return true;
+    }
+
+    // Flights whose seat count is sold out drop out of every bitmap
+    void updateAvailability(const Flight& flight) {
+        uint32_t slot = flight.getInventorySlot();
+        uint8_t open = flight.getAvailableSeats() > 0;
+        if (slot < bookable.size() && bookable[slot] != open) {
+            bookable[slot] = open;
+            refreshBitmaps(slot);
+        }
+    }
+
+    // A booking in the class took (+1) or gave back (-1) a seat
+    void updateClassSales(uint32_t slot, SeatClass seatClass, int delta) {
+        if (slot >= maps.size()) return;
+        maps[slot].sold[int(seatClass)] += delta;
+        refreshBitmaps(slot, int(seatClass));
+    }
+
+    // First free seat of the class matching the preference (falling back to
+    // any free seat in the class); returns the seat number or -1
+    int claimSeat(uint32_t slot, SeatClass seatClass, SeatPreference pref = SeatPreference::Any) {
+        SeatMap& m = maps[slot];
+        int fallback = -1;
+        for (int row = 0; row < m.rows; row++) {
+            if (m.classOfRow(row) != int(seatClass)) continue;
+            for (int col = 0; col < m.width; col++) {
+                int seat = row * m.width + col;
+                if (m.isOccupied(seat)) continue;
+                bool match = pref == SeatPreference::Any || (pref == SeatPreference::Window && m.isWindow(col)) ||
+                             (pref == SeatPreference::Aisle && m.isAisle(col));
+                if (match) {
+                    toggleSeat(slot, seat);
+                    return seat;
+                }
+                if (fallback < 0) fallback = seat;
+            }
+        }
+        if (fallback >= 0) toggleSeat(slot, fallback);
+        return fallback;
+    }
+
+    bool claimSeatNumber(uint32_t slot, int seat) {
+        SeatMap& m = maps[slot];
+        if (seat < 0 || seat >= m.totalSeats || m.isOccupied(seat)) return false;
+        toggleSeat(slot, seat);
+        return true;
+    }
+
+    void releaseSeat(uint32_t slot, int seat) {
+        SeatMap& m = maps[slot];
+        if (seat < 0 || seat >= m.totalSeats || !m.isOccupied(seat)) return;
+        toggleSeat(slot, seat);
+    }
+
+    // Flights with at least one seat of this kind free in the class
+    const RoaringBitmap& flightsWith(SeatClass seatClass, Attribute attribute) const {
+        return attributeBits[int(seatClass)][int(attribute)];
+    }
+
+    // Flights with at least `seats` free in the class (exact for any count)
+    RoaringBitmap flightsWithFreeSeats(SeatClass seatClass, int seats) const {
+        if (seats <= 1) return freeBits[int(seatClass)][0];
+        int level = 0;
+        while (level + 1 < FREE_LEVELS && (1 << (level + 1)) <= seats) level++;
+        const RoaringBitmap& candidates = freeBits[int(seatClass)][level];
+        if ((1 << level) == seats) return candidates;
+        RoaringBitmap out;
+        candidates.forEach([&](uint32_t slot) {
+            if (maps[slot].forSale(int(seatClass)) >= seats) out.add(slot);
+        });
+        return out;
+    }
+
+    const RoaringBitmap& flightsFrom(const string& origin) const {
+        auto it = byOrigin.find(origin);
+        return it != byOrigin.end() ? it->second : none;
+    }
+
+    // day = whole days since the schedule epoch (see dayOf)
+    const RoaringBitmap& flightsDepartingOn(TimeMinutes day) const {
+        auto it = byDay.find(day);
+        return it != byDay.end() ? it->second : none;
+    }
+
+    // Per-flight counters, for checking the bitmaps or finer filtering
+    int attributeCount(uint32_t slot, SeatClass seatClass, Attribute attribute) const {
+        return maps[slot].counts[int(seatClass)].attributes[int(attribute)];
+    }
+    int freeSeats(uint32_t slot, SeatClass seatClass) const { return maps[slot].counts[int(seatClass)].free; }
+    int seatsForSale(uint32_t slot, SeatClass seatClass) const { return maps[slot].forSale(int(seatClass)); }
+
+    // Recounts an attribute by walking the flight's seat map (what a
+    // per-flight SeatAssigner scan costs); used to check the counters
+    int countByWalking(uint32_t slot, SeatClass seatClass, Attribute attribute) const {
+        SeatMap copy = maps[slot];
+        for (auto& c : copy.counts) c = ClassCounts();
+        for (int row = 0; row < copy.rows; row++) copy.countRow(row, +1);
+        return copy.counts[int(seatClass)].attributes[int(attribute)];
+    }
+
+    string seatLabel(uint32_t slot, int seat) const {
+        static const char letters[] = "ABCDEFGHK";
+        const SeatMap& m = maps[slot];
+        return to_string(seat / m.width + 1) + letters[seat % m.width];
+    }
+
+    size_t memoryBytes() const {
+        size_t bytes = maps.capacity() * sizeof(SeatMap) + bookable.capacity();
+        for (const auto& m : maps) bytes += m.occupied.capacity() * sizeof(uint64_t);
+        for (const auto& perClass : attributeBits) {
+            for (const auto& b : perClass) bytes += b.memoryBytes();
+        }
+        for (const auto& perClass : freeBits) {
+            for (const auto& b : perClass) bytes += b.memoryBytes();
+        }
+        for (const auto& entry : byOrigin) bytes += entry.second.memoryBytes();
+        for (const auto& entry : byDay) bytes += entry.second.memoryBytes();
+        return bytes;
+    }
+};
+
+// ============================================================================
+// BOOKING STORAGE: pooled bookings and flat indexes for the booking hot path
+// ============================================================================
+
+// Fixed-size blocks for shared bookings (one control block plus Booking per
+// allocate_shared), recycled through a free list. Larger requests go to the
+// heap. Blocks live until the pool does; allocators share ownership of the
+// pool, so bookings may outlive the system that created them.
+class BlockPool {
+private:
+    static constexpr size_t BLOCKS_PER_CHUNK = 256;
+    const size_t blockSize;
+    mutex poolMutex; // the last owner of a booking may release it on any thread
+    vector<unique_ptr<char[]>> chunks;
+    void* freeList = nullptr;
+    size_t capacity = 0;
+
+    void addChunk(size_t blocks) {
+        chunks.push_back(make_unique<char[]>(blocks * blockSize));
+        char* base = chunks.back().get();
+        for (size_t i = blocks; i-- > 0;) {
+            void* block = base + i * blockSize;
+            *static_cast<void**>(block) = freeList;
+            freeList = block;
+        }
+        capacity += blocks;
+    }
+
+public:
+    explicit BlockPool(size_t bytes) : blockSize((max(bytes, sizeof(void*)) + 15) & ~size_t(15)) {}
+
+    void* allocate(size_t bytes) {
+        if (bytes > blockSize) return ::operator new(bytes);
+        lock_guard<mutex> guard(poolMutex);
+        if (!freeList) addChunk(BLOCKS_PER_CHUNK);
+        void* block = freeList;
+        freeList = *static_cast<void**>(block);
+        return block;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        if (bytes > blockSize) return ::operator delete(p);
+        lock_guard<mutex> guard(poolMutex);
+        *static_cast<void**>(p) = freeList;
+        freeList = p;
+    }
+
+    // Grows the pool to at least `blocks` blocks in one chunk
+    void reserve(size_t blocks) {
+        lock_guard<mutex> guard(poolMutex);
+        if (blocks > capacity) addChunk(blocks - capacity);
+    }
+};
+
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+    shared_ptr<BlockPool> pool;
+
+    explicit PoolAllocator(shared_ptr<BlockPool> p) : pool(move(p)) {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(pool->allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { pool->deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const { return pool == other.pool; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const { return pool != other.pool; }
+};
+
+// BookingId -> booking, open addressing with linear probing. Erase shifts
+// later entries back instead of leaving tombstones.
+class BookingIndex {
+private:
+    vector<shared_ptr<Booking>> table; // power-of-two size, null = empty
+    size_t count = 0;
+
+    static size_t hashId(BookingId id) { return static_cast<size_t>((id * 0x9E3779B97F4A7C15ULL) >> 20); }
+
+    size_t probe(BookingId id) const {
+        size_t mask = table.size() - 1;
+        size_t pos = hashId(id) & mask;
+        while (table[pos] && table[pos]->getBookingId() != id) pos = (pos + 1) & mask;
+        return pos;
+    }
+
+    void rehash(size_t size) {
+        vector<shared_ptr<Booking>> old(size);
+        old.swap(table);
+        for (auto& booking : old) {
+            if (booking) table[probe(booking->getBookingId())] = move(booking);
+        }
+    }
+
+public:
+    BookingIndex() : table(64) {}
+
+    void insert(const shared_ptr<Booking>& booking) {
+        table[probe(booking->getBookingId())] = booking;
+        if (++count * 10 > table.size() * 7) rehash(table.size() * 2); // keep load factor <= 0.7
+    }
+
+    const shared_ptr<Booking>* find(BookingId id) const {
+        const shared_ptr<Booking>& entry = table[probe(id)];
+        return entry ? &entry : nullptr;
+    }
+
+    void erase(BookingId id) {
+        size_t mask = table.size() - 1;
+        size_t hole = probe(id);
+        if (!table[hole]) return;
+        table[hole].reset();
+        count--;
+        // Move back any entry whose probe run passes through the hole
+        for (size_t pos = (hole + 1) & mask; table[pos]; pos = (pos + 1) & mask) {
+            size_t home = hashId(table[pos]->getBookingId()) & mask;
+            if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+                table[hole] = move(table[pos]);
+                hole = pos;
+            }
+        }
+    }
+
+    // Sized so `bookings` entries fit without rehashing
+    void reserve(size_t bookings) {
+        size_t size = table.size();
+        while (bookings * 10 > size * 7) size *= 2;
+        if (size != table.size()) rehash(size);
+    }
+};
+
+// Flight number -> inventory slot, open addressing. Keys are views of the
+// flights' own numbers (flights are never removed). The first flight added
+// under a number keeps it.
+class FlightNumberIndex {
+private:
+    struct Entry {
+        string_view number; // empty = unused
+        uint32_t slot;
+    };
+
+    vector<Entry> table{64, Entry{}};
+    size_t count = 0;
+
+    size_t probe(string_view flightNumber) const {
+        size_t mask = table.size() - 1;
+        size_t pos = hashString(flightNumber) & mask;
+        while (!table[pos].number.empty() && table[pos].number != flightNumber) pos = (pos + 1) & mask;
+        return pos;
+    }
+
+public:
+    static constexpr uint32_t NONE = numeric_limits<uint32_t>::max();
+
+    void add(string_view flightNumber, uint32_t slot) {
+        if (flightNumber.empty()) return;
+        size_t pos = probe(flightNumber);
+        if (!table[pos].number.empty()) return;
+        table[pos] = Entry{flightNumber, slot};
+        if (++count * 10 <= table.size() * 7) return; // keep load factor <= 0.7
+        vector<Entry> old(table.size() * 2, Entry{});
+        old.swap(table);
+        for (const Entry& e : old) {
+            if (!e.number.empty()) table[probe(e.number)] = e;
+        }
+    }
+
+    uint32_t find(string_view flightNumber) const {
+        const Entry& e = table[probe(flightNumber)];
+        return e.number.empty() ? NONE : e.slot;
+    }
+};
+
+// ============================================================================
+// FLIGHT BOOKING SYSTEM MANAGER
+// ============================================================================
+
+class FlightBookingSystem : public InventoryListener {
+private:
+    vector<shared_ptr<Flight>> flights;
+    vector<shared_ptr<Booking>> bookings;
+    BookingIndex bookingIndex; // O(1) lookup by ID
+    FlightNumberIndex flightsByNumber;
+    // Bookings and their control blocks come from one pool (see createBooking)
+    shared_ptr<BlockPool> bookingPool = make_shared<BlockPool>(sizeof(Booking) + 64);
+    BookingIdGenerator idGenerator;
+    PassengerRegistry passengerRegistry;
+    FlightQueryEngine queryEngine;
+    InventorySnapshots snapshots; // lock-free read path for searches and displays
+    vector<Waitlist> waitlists; // by flight inventory slot
+    SharedSeatInventory* sharedInventory = nullptr;
+    mutable QueryResultCache queryCache;
+    AutocompleteIndex autocompleteIndex;
+    FleetSeatIndex seatIndex;
+    FareCalendar fareCalendar{queryEngine}; // empty until buildFareCalendar
+    TraceRecorder* tracer = nullptr; // records API calls while attached
+
+    // Hand a freed seat to the best waitlisted booking on that flight
+    void promoteFromWaitlist(const Flight& flight) {
+        Waitlist& waitlist = waitlists[flight.getInventorySlot()];
+        if (auto next = waitlist.pop()) {
+            // The seat may already be gone (e.g. to another process); keep the place in line
+            if (!next->confirmFromWaitlist()) waitlist.push(next);
+        }
+    }
+
+public:
+    explicit FlightBookingSystem(uint16_t shardId = 0) : idGenerator(shardId) {}
+
+    // Records subsequent API calls into the trace; null detaches
+    void attachTracer(TraceRecorder* recorder) { tracer = recorder; }
+
+    // False (and nothing added) for a null flight or an invalid seat count
+    bool addFlight(shared_ptr<Flight> flight) {
+        if (!flight || !Flight::isValidSeatCount(flight->getTotalSeats())) return false;
+        if (tracer) tracer->addFlight(*flight);
+        if (sharedInventory) {
+            flight->attachSharedSeats(sharedInventory->findOrInsert(flight->getFlightNumber(), flight->getTotalSeats(),
+                                                                       flight->getAvailableSeats()));
+        }
+        flight->attachInventory(this, static_cast<uint32_t>(flights.size()));
+        flightsByNumber.add(flight->getFlightNumber(), flight->getInventorySlot());
+        flights.push_back(flight);
+        waitlists.emplace_back();
+        queryEngine.addFlight(*flight);
+        snapshots.addFlight(*flight);
+        queryCache.onFlightAdded(*flight);
+        autocompleteIndex.addTerm(flight->getDepartureCity(), AutocompleteIndex::Kind::City);
+        autocompleteIndex.addTerm(flight->getArrivalCity(), AutocompleteIndex::Kind::City);
+        autocompleteIndex.addTerm(flight->getFlightNumber(), AutocompleteIndex::Kind::FlightNumber);
+        seatIndex.addFlight(*flight);
+        fareCalendar.addFlight(*flight);
+        return true;
+    }
+
+    void onSeatsChanged(const Flight& flight) override {
+        queryEngine.updateSeats(flight);
+        snapshots.updateSeats(flight);
+        seatIndex.updateAvailability(flight);
+        fareCalendar.update(flight, flight.getFare());
+    }
+
+    void onClassSalesChanged(const Flight& flight, SeatClass seatClass, int delta) override {
+        seatIndex.updateClassSales(flight.getInventorySlot(), seatClass, delta);
+    }
+
+    void onFareChanged(const Flight& flight, double previousFare) override {
+        if (tracer) tracer->setFare(flight.getFlightNumber(), flight.getFare());
+        queryEngine.updatePrice(flight);
+        snapshots.updatePrice(flight);
+        fareCalendar.update(flight, previousFare);
+    }
+
+    // Builds the lowest-fare-per-route-and-day calendar over the inventory;
+    // seat and fare changes keep it current from then on
+    void buildFareCalendar(TimeMinutes firstDay = 0, int days = 365, unsigned threads = 0) {
+        fareCalendar.build(firstDay, days, threads);
+    }
+
+    const FareCalendar& getFareCalendar() const { return fareCalendar; }
+
+    // Keeps seat counts of current and future flights in a shared segment.
+    // Flights that do not fit the segment keep local counts.
+    void attachSharedInventory(SharedSeatInventory& inventory) {
+        sharedInventory = &inventory;
+        for (auto& flight : flights) {
+            flight->attachSharedSeats(inventory.findOrInsert(flight->getFlightNumber(), flight->getTotalSeats(),
+                                                             flight->getAvailableSeats()));
+            onSeatsChanged(*flight);
+        }
+    }
+
+    // Refreshes local indexes for seats other processes changed; returns how many flights changed
+    size_t syncSharedInventory() {
+        size_t changed = 0;
+        for (auto& flight : flights) {
+            if (flight->pollSharedChanges()) {
+                onSeatsChanged(*flight);
+                changed++;
+            }
+        }
+        return changed;
+    }
+
+    // Preallocates booking storage so the next `count` creates do not touch
+    // the heap (see alloctest)
+    void reserveBookings(size_t count) {
+        bookings.reserve(bookings.size() + count);
+        bookingIndex.reserve(bookings.size() + count);
+        bookingPool->reserve(bookings.size() + count);
+    }
+
+    // Repeat travellers are deduplicated by passport: the booking is attached
+    // to the passenger already on file. With storage reserved and the
+    // passenger on file this does not allocate.
+    shared_ptr<Booking> createBooking(const shared_ptr<Passenger>& passenger, string_view flightNumber,
+                                      SeatClass seatClass) {
+        FBS_METRIC_SCOPE(MetricOp::CreateBooking);
+        uint32_t flightSlot = flightsByNumber.find(flightNumber);
+        if (flightSlot == FlightNumberIndex::NONE) {
+            if (tracer) tracer->createBooking(*passenger, flightNumber, seatClass, 0);
+            FBS_METRIC_FAILURE(MetricOp::CreateBooking);
+            return nullptr;
+        }
+        uint32_t slot = passengerRegistry.intern(passenger);
+        auto booking = allocate_shared<Booking>(PoolAllocator<Booking>(bookingPool), idGenerator.next(),
+                                                flights[flightSlot], passengerRegistry.passengerAt(slot), seatClass);
+        bookings.push_back(booking);
+        bookingIndex.insert(booking);
+        passengerRegistry.addBooking(slot, *booking);
+        if (tracer) tracer->createBooking(*passenger, flightNumber, seatClass, booking->getBookingId());
+        return booking;
+    }
+
+    shared_ptr<Flight> findFlight(string_view flightNumber) const {
+        uint32_t slot = flightsByNumber.find(flightNumber);
+        return slot != FlightNumberIndex::NONE ? flights[slot] : nullptr;
+    }
+
+    // Hash lookup by booking ID
+    shared_ptr<Booking> findBooking(BookingId id) const {
+        const shared_ptr<Booking>* entry = bookingIndex.find(id);
+        return entry ? *entry : nullptr;
+    }
+
+    // Confirms if a seat is free, otherwise puts the booking on the flight's waitlist
+    BookingStatus confirmOrWaitlist(BookingId id) {
+        if (tracer) tracer->confirmOrWaitlist(id);
+        auto booking = findBooking(id);
+        if (!booking) return BookingStatus::Cancelled;
+        if (booking->getStatus() == BookingStatus::Pending && !booking->confirmBooking()) {
+            booking->markWaitlisted();
+            waitlists[booking->getFlight()->getInventorySlot()].push(booking);
+        }
+        return booking->getStatus();
+    }
+
+    // Confirms a booking against a seat the caller already took from its
+    // flight; a waitlisted booking also leaves the waitlist. False if the
+    // booking could not take the seat (the caller still holds it).
+    bool confirmReservedSeat(Booking& booking) {
+        if (tracer) tracer->bookingCall(TraceOp::ConfirmReservedSeat, booking.getBookingId());
+        bool wasWaitlisted = booking.getStatus() == BookingStatus::Waitlisted;
+        if (!booking.confirmReservedSeat()) return false;
+        if (wasWaitlisted) waitlists[booking.getFlight()->getInventorySlot()].forget();
+        return true;
+    }
+
+    // Holds a seat for a pending booking, e.g. while its payment is
+    // authorized. The seat counts as sold until confirmHeldSeat, releaseHeldSeat
+    // or cancelBooking. False if the booking is not pending or the flight is full.
+    bool holdSeat(BookingId id) {
+        if (tracer) tracer->bookingCall(TraceOp::HoldSeat, id);
+        auto booking = findBooking(id);
+        return booking && booking->holdSeat();
+    }
+
+    // Confirms a booking against its held seat; false if the hold is gone
+    // (e.g. the booking was cancelled in the meantime)
+    bool confirmHeldSeat(BookingId id) {
+        if (tracer) tracer->bookingCall(TraceOp::ConfirmHeldSeat, id);
+        auto booking = findBooking(id);
+        return booking && booking->hasHeldSeat() && booking->confirmBooking();
+    }
+
+    // Gives a held seat back; it goes straight to the next waitlisted booking
+    bool releaseHeldSeat(BookingId id) {
+        if (tracer) tracer->bookingCall(TraceOp::ReleaseHeldSeat, id);
+        auto booking = findBooking(id);
+        if (!booking || !booking->releaseHeldSeat()) return false;
+        promoteFromWaitlist(*booking->getFlight());
+        return true;
+    }
+
+    // Cancels a booking; a confirmed or held seat goes straight to the next waitlisted booking
+    bool cancelBooking(BookingId id) {
+        if (tracer) tracer->cancelBooking(id);
+        auto booking = findBooking(id);
+        if (!booking || booking->getStatus() == BookingStatus::Cancelled) return false;
+        BookingStatus previous = booking->getStatus();
+        if (booking->getSeatNumber() >= 0) {
+            seatIndex.releaseSeat(booking->getFlight()->getInventorySlot(), booking->getSeatNumber());
+            booking->setSeatNumber(-1);
+        }
+        bool seatFreed = booking->cancel();
+        if (previous == BookingStatus::Waitlisted) {
+            waitlists[booking->getFlight()->getInventorySlot()].forget();
+        } else if (seatFreed) {
+            promoteFromWaitlist(*booking->getFlight());
+        }
+        return true;
+    }
+
+    // Seat selection for a confirmed booking, in its fare class; returns the seat number or -1
+    int assignSeat(BookingId id, SeatPreference pref = SeatPreference::Any) {
+        if (tracer) tracer->assignSeat(id, pref);
+        auto booking = findBooking(id);
+        if (!booking || !booking->isConfirmed() || booking->getSeatNumber() >= 0) return -1;
+        int seat = seatIndex.claimSeat(booking->getFlight()->getInventorySlot(), booking->getSeatClass(), pref);
+        booking->setSeatNumber(seat);
+        return seat;
+    }
+
+    const FleetSeatIndex& getSeatIndex() const { return seatIndex; }
+
+    // e.g. flights tomorrow from Delhi with a free window pair in Economy
+    vector<shared_ptr<Flight>> findFlightsWithSeats(const string& origin, TimeMinutes day, SeatClass seatClass,
+                                                    FleetSeatIndex::Attribute attribute) const {
+        vector<shared_ptr<Flight>> results;
+        RoaringBitmap match = seatIndex.flightsFrom(origin) & seatIndex.flightsDepartingOn(day) &
+                              seatIndex.flightsWith(seatClass, attribute);
+        match.forEach([&](uint32_t slot) { results.push_back(flights[slot]); });
+        return results;
+    }
+
+    size_t getWaitlistSize(const Flight& flight) const {
+        return waitlists[flight.getInventorySlot()].size();
+    }
+
+    shared_ptr<Passenger> registerPassenger(string_view name, string_view passport,
+                                            string_view contact, string_view email) {
+        return passengerRegistry.registerPassenger(name, passport, contact, email);
+    }
+
+    shared_ptr<Passenger> findPassenger(string_view passport) const {
+        return passengerRegistry.findByPassport(passport);
+    }
+
+    vector<shared_ptr<Booking>> getBookingsForPassenger(string_view passport) const {
+        return passengerRegistry.bookingsFor(passport);
+    }
+
+    // ============================================================================
+    // SEARCH ALGORITHMS
+    // ============================================================================
+
+    // Linear search for flights by destination, ignoring case and stray
+    // whitespace; repeated cities are served from the query cache
+    shared_ptr<Flight> findFlightByDestination(const string& destination) const {
+        FBS_METRIC_SCOPE(MetricOp::FindFlightByDestination);
+        if (tracer) tracer->findFlightByDestination(destination);
+        auto key = QueryResultCache::destinationKey(destination);
+        shared_ptr<Flight> cached;
+        if (queryCache.lookup(key, cached)) return cached;
+        for (const auto& flight : flights) {
+            if (matchesSearchText(flight->getArrivalCity(), key.city)) {
+                queryCache.store(key, flight);
+                return flight;
+            }
+        }
+        queryCache.store(key, nullptr);
+        return nullptr;
+    }
+
+    // Linear search for flights within price range. Reads an inventory
+    // snapshot, so it is safe to call while another thread books seats.
+    vector<shared_ptr<Flight>> findFlightsByPriceRange(double minPrice, double maxPrice) const {
+        FBS_METRIC_SCOPE(MetricOp::FindFlightsByPriceRange);
+        if (tracer) tracer->findFlightsByPriceRange(minPrice, maxPrice);
+        return snapshots.read([&](const InventorySnapshots::Version& inventory) {
+            vector<shared_ptr<Flight>> results;
+            for (size_t i = 0; i < inventory.size(); i++) {
+                const auto& entry = inventory[i];
+                if (entry.price >= minPrice && entry.price <= maxPrice) {
+                    results.push_back(entry.flight->shared_from_this());
+                }
+            }
+            return results;
+        });
+    }
+
+    QueryCacheStats getQueryCacheStats() const { return queryCache.getStats(); }
+
+    // Top-k cities / flight numbers for partial or misspelled input, busiest first
+    vector<AutocompleteIndex::Completion> autocomplete(string_view input, size_t k = 5) const {
+        return autocompleteIndex.complete(input, k);
+    }
+
+    const AutocompleteIndex& getAutocompleteIndex() const { return autocompleteIndex; }
+
+    // Flights from origin departing in [from, to], in departure order: O(log n + k)
+    vector<shared_ptr<Flight>> findFlightsDepartingBetween(const string& origin, TimeMinutes from, TimeMinutes to) const {
+        if (tracer) tracer->findFlightsDepartingBetween(origin, from, to);
+        vector<shared_ptr<Flight>> results;
+        queryEngine.forEachDeparture(origin, from, to, [&](const FlightRecord& r) {
+            results.push_back(flights[r.flight->getInventorySlot()]);
+        });
+        return results;
+    }
+
+    // Multi-criteria search; iterate the cursor page by page
+    FlightCursor query(const FlightQuery& q) const {
+        FBS_METRIC_SCOPE(MetricOp::Query);
+        if (tracer) tracer->query(q);
+        return queryEngine.query(q);
+    }
+
+    // Binary search for flights by price (assuming flights sorted by price)
+    shared_ptr<Flight> findCheapestFlight(double maxPrice) const {
+        FBS_METRIC_SCOPE(MetricOp::FindCheapestFlight);
+        if (tracer) tracer->findCheapestFlight(maxPrice);
+        // For binary search, we need sorted data - sort flights by price first
+        vector<shared_ptr<Flight>> sortedFlights = flights;
+        sort(sortedFlights.begin(), sortedFlights.end(),
+             [](const shared_ptr<Flight>& a, const shared_ptr<Flight>& b) {
+                 return a->getFare() < b->getFare();
+             });
+
+        int left = 0, right = sortedFlights.size() - 1;
+        shared_ptr<Flight> result = nullptr;
+
+        while (left <= right) {
+            int mid = left + (right - left) / 2;
+            double price = sortedFlights[mid]->getFare();
+
+            if (price <= maxPrice) {
+                result = sortedFlights[mid];
+                left = mid + 1; // Look for cheaper options
+            } else {
+                right = mid - 1;
+            }
+        }
+        return result;
+    }
+
+    // ============================================================================
+    // SORTING ALGORITHMS
+    // ============================================================================
+
+    // Sort flights by price using introsort: the price of each flight is read
+    // once into a key array, which is sorted with a three-way quicksort
+    // (median-of-three pivot, insertion sort below a cutoff) that falls back to
+    // heapsort when recursion gets too deep. O(n log n) worst case; runs of
+    // equal prices are settled in a single partition pass.
+    struct PriceKey {
+        double price;
+        uint32_t index;
+    };
+
+    static constexpr ptrdiff_t INSERTION_SORT_CUTOFF = 16;
+
+    void sortFlightsByPrice(vector<shared_ptr<Flight>>& flightList) {
+        FBS_METRIC_SCOPE(MetricOp::SortFlightsByPrice);
+        size_t n = flightList.size();
+        if (n < 2) return;
+        vector<PriceKey> keys(n);
+        for (size_t i = 0; i < n; i++) keys[i] = PriceKey{flightList[i]->getFare(), static_cast<uint32_t>(i)};
+
+        int depthLimit = 2 * static_cast<int>(log2(static_cast<double>(n)));
+        introSort(keys.data(), keys.data() + n, depthLimit);
+
+        vector<shared_ptr<Flight>> sorted;
+        sorted.reserve(n);
+        for (const PriceKey& k : keys) sorted.push_back(move(flightList[k.index]));
+        flightList.swap(sorted);
+    }
+
+    static void introSort(PriceKey* first, PriceKey* last, int depthLimit) {
+        while (last - first > INSERTION_SORT_CUTOFF) {
+            if (depthLimit-- == 0) {
+                heapSort(first, last);
+                return;
+            }
+            PriceKey* lt;
+            PriceKey* gt;
+            partitionThreeWay(first, last, lt, gt);
+            // Recurse into the smaller side, loop on the larger: O(log n) stack
+            if (lt - first < last - gt) {
+                introSort(first, lt, depthLimit);
+                first = gt;
+            } else {
+                introSort(gt, last, depthLimit);
+                last = lt;
+            }
+        }
+        insertionSort(first, last);
+    }
+
+    // Dijkstra's Dutch flag partition around a median-of-three pivot:
+    // [first, lt) < pivot, [lt, gt) == pivot, [gt, last) > pivot
+    static void partitionThreeWay(PriceKey* first, PriceKey* last, PriceKey*& lt, PriceKey*& gt) {
+        double a = first->price, b = first[(last - first) / 2].price, c = (last - 1)->price;
+        double pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+
+        lt = first;
+        gt = last;
+        PriceKey* i = first;
+        while (i < gt) {
+            if (i->price < pivot) {
+                swap(*lt++, *i++);
+            } else if (pivot < i->price) {
+                swap(*i, *--gt);
+            } else {
+                i++;
+            }
+        }
+    }
+
+    static void insertionSort(PriceKey* first, PriceKey* last) {
+        for (PriceKey* i = first + 1; i < last; i++) {
+            PriceKey key = *i;
+            PriceKey* j = i;
+            while (j > first && key.price < (j - 1)->price) {
+                *j = *(j - 1);
+                j--;
+            }
+            *j = key;
+        }
+    }
+
+    static void siftDown(PriceKey* heap, ptrdiff_t root, ptrdiff_t size) {
+        PriceKey item = heap[root];
+        for (ptrdiff_t child = 2 * root + 1; child < size; child = 2 * root + 1) {
+            if (child + 1 < size && heap[child].price < heap[child + 1].price) child++;
+            if (!(item.price < heap[child].price)) break;
+            heap[root] = heap[child];
+            root = child;
+        }
+        heap[root] = item;
+    }
+
+    static void heapSort(PriceKey* first, PriceKey* last) {
+        ptrdiff_t n = last - first;
+        for (ptrdiff_t i = n / 2 - 1; i >= 0; i--) siftDown(first, i, n);
+        for (ptrdiff_t end = n - 1; end > 0; end--) {
+            swap(first[0], first[end]);
+            siftDown(first, 0, end);
+        }
+    }
+
+    // Sort bookings by total price using merge sort
+    void sortBookingsByPrice() {
+        FBS_METRIC_SCOPE(MetricOp::SortBookingsByPrice);
+        mergeSort(bookings, 0, bookings.size() - 1);
+    }
+
+    void mergeSort(vector<shared_ptr<Booking>>& arr, int left, int right) {
+        if (left < right) {
+            int mid = left + (right - left) / 2;
+            mergeSort(arr, left, mid);
+            mergeSort(arr, mid + 1, right);
+            merge(arr, left, mid, right);
+        }
+    }
+
+    void merge(vector<shared_ptr<Booking>>& arr, int left, int mid, int right) {
+        int n1 = mid - left + 1;
+        int n2 = right - mid;
+
+        vector<shared_ptr<Booking>> L(n1), R(n2);
+        for (int i = 0; i < n1; i++) L[i] = arr[left + i];
+        for (int j = 0; j < n2; j++) R[j] = arr[mid + 1 + j];
+
+        int i = 0, j = 0, k = left;
+        while (i < n1 && j < n2) {
+            if (L[i]->getTotalPrice() <= R[j]->getTotalPrice()) {
+                arr[k] = L[i]; i++;
+            } else {
+                arr[k] = R[j]; j++;
+            }
+            k++;
+        }
+
+        while (i < n1) { arr[k] = L[i]; i++; k++; }
+        while (j < n2) { arr[k] = R[j]; j++; k++; }
+    }
+
+    // ============================================================================
+    // DISPLAY METHODS
+    // ============================================================================
+
+    // Prints one consistent snapshot of the inventory
+    void displayAllFlights() const {
+        snapshots.read([](const InventorySnapshots::Version& inventory) {
+            cout << "Available Flights:" << endl;
+            for (size_t i = 0; i < inventory.size(); i++) {
+                const auto& entry = inventory[i];
+                entry.flight->printInfo(cout, entry.availableSeats);
+                cout << "Base Price: $" << entry.price << endl << endl;
+            }
+        });
+    }
+
+    void displayAllBookings() const {
+        cout << "All Bookings:" << endl;
+        for (const auto& booking : bookings) {
+            booking->displayBooking();
+            cout << "------------------------" << endl;
+        }
+    }
+
+    // Live bookings only; sealed bookings are summed by BookingArchive
+    double getTotalRevenue() const {
+        double total = 0.0;
+        for (const auto& booking : bookings) {
+            if (booking->isConfirmed()) {
+                total += booking->getTotalPrice();
+            }
+        }
+        return total;
+    }
+
+    // Moves confirmed bookings of flights that departed before `now` into the
+    // archive and drops them from the live indexes. Returns how many were sealed.
+    size_t archiveDepartedBookings(BookingArchive& archive, TimeMinutes now) {
+        auto sealed = [now](const Booking& b) {
+            return b.isConfirmed() && b.getFlight()->getDepartureMinutes() < now;
+        };
+        vector<shared_ptr<Booking>> rows;
+        for (const auto& booking : bookings) {
+            if (sealed(*booking)) rows.push_back(booking);
+        }
+        if (rows.empty() || !archive.seal(rows)) return 0;
+
+        for (const auto& booking : rows) bookingIndex.erase(booking->getBookingId());
+        passengerRegistry.removeBookings(sealed);
+        bookings.erase(remove_if(bookings.begin(), bookings.end(), [&](const shared_ptr<Booking>& b) { return sealed(*b); }),
+                       bookings.end());
+        bookings.shrink_to_fit();
+        return rows.size();
+    }
+
+    const vector<shared_ptr<Flight>>& getFlights() const { return flights; }
+    const InventorySnapshots& getInventory() const { return snapshots; }
+    const FlightQueryEngine& getQueryEngine() const { return queryEngine; }
+    const vector<shared_ptr<Booking>>& getBookings() const { return bookings; }
+};
+
+// ============================================================================
+// ADVANCED ALGORITHMS
+// ============================================================================
+
+// Dijkstra's Algorithm for route optimization
+class RouteOptimizer {
+private:
+    unordered_map<string, vector<pair<string, double>>> graph; // city -> [(destination, price)]
+    TraceRecorder* tracer = nullptr;
+
+public:
+    void attachTracer(TraceRecorder* recorder) { tracer = recorder; }
+
+    void addFlightRoute(const string& from, const string& to, double price) {
+        graph[from].push_back({to, price});
+        graph[to].push_back({from, price}); // Assuming bidirectional
+    }
+
+    double findCheapestRoute(const string& start, const string& end) {
+        FBS_METRIC_SCOPE(MetricOp::FindCheapestRoute);
+        if (tracer) tracer->findCheapestRoute(start, end);
+        unordered_map<string, double> distances;
+        priority_queue<pair<double, string>, vector<pair<double, string>>, greater<pair<double, string>>> pq;
+
+        for (auto& city : graph) {
+            distances[city.first] = numeric_limits<double>::infinity();
+        }
+        distances[start] = 0;
+        pq.push({0, start});
+
+        while (!pq.empty()) {
+            auto [cost, current] = pq.top(); pq.pop();
+
+            if (cost > distances[current]) continue;
+
+            for (auto& [neighbor, price] : graph[current]) {
+                double newCost = cost + price;
+                if (newCost < distances[neighbor]) {
+                    distances[neighbor] = newCost;
+                    pq.push({newCost, neighbor});
+                }
+            }
+        }
+
+        return distances[end];
+    }
+};
+
+// Multi-leg itineraries over real flights and their live seat counts
+struct ItineraryQuery {
+    string origin;
+    string destination;
+    TimeMinutes departAfter = numeric_limits<TimeMinutes>::min(); // first leg, inclusive
+    TimeMinutes departBefore = numeric_limits<TimeMinutes>::max();
+    int seats = 1;             // every leg needs this many free seats
+    int maxLegs = 3;
+    int minConnection = 45;    // minutes between arrival and next departure
+    int maxTripMinutes = 36 * 60; // first departure to final arrival
+    size_t k = 5;
+};
+
+struct Itinerary {
+    vector<const Flight*> legs;
+    double price = 0.0; // per passenger, sum of leg fares
+    TimeMinutes departure = 0;
+    TimeMinutes arrival = 0;
+};
+
+// Best-first search over (city, arrival time) labels, cheapest first and
+// earliest arrival on ties, so the first k labels to reach the destination
+// are the k best itineraries. Legs without enough free seats, connections
+// shorter than minConnection, trips longer than maxTripMinutes and revisited
+// cities are pruned while expanding. A label is dropped when k labels already
+// settled at its city are at least as good on price, arrival, start time and
+// legs used, since whatever it can reach they reach too.
+//
+// All scratch space (label pool, heap, per-city chains) is sized once and
+// reused, so expansion never allocates; maxLabels bounds the memory of one
+// query and the result says when it ran out.
+class ItinerarySearch {
+public:
+    struct Result {
+        vector<Itinerary> itineraries;
+        size_t labelsUsed = 0;
+        bool truncated = false; // label pool exhausted; results may miss itineraries
+    };
+
+private:
+    static constexpr uint32_t NONE = numeric_limits<uint32_t>::max();
+
+    struct Label {
+        double cost;
+        TimeMinutes arrival;
+        TimeMinutes start;
+        uint32_t city;
+        uint32_t flight;      // record slot of the last leg
+        uint32_t parent;      // previous label, NONE for the first leg
+        uint32_t nextSettled; // chain of settled labels at the same city
+        uint8_t legs;
+    };
+
+    const FlightQueryEngine& engine;
+    size_t maxLabels;
+    vector<Label> labels;
+    vector<uint32_t> heap;
+    vector<uint32_t> settledHead; // by city
+
+    // Min-heap order: cheaper, then earlier arrival, then fewer legs
+    bool worse(uint32_t a, uint32_t b) const {
+        const Label& x = labels[a];
+        const Label& y = labels[b];
+        if (x.cost != y.cost) return x.cost > y.cost;
+        if (x.arrival != y.arrival) return x.arrival > y.arrival;
+        return x.legs > y.legs;
+    }
+
+    bool visits(uint32_t label, uint32_t city) const {
+        for (uint32_t l = label; l != NONE; l = labels[l].parent) {
+            if (labels[l].city == city || engine.record(labels[l].flight).origin == city) return true;
+        }
+        return false;
+    }
+
+    bool dominated(const Label& b, size_t k) const {
+        size_t dominators = 0;
+        for (uint32_t l = settledHead[b.city]; l != NONE; l = labels[l].nextSettled) {
+            const Label& a = labels[l];
+            if (a.cost <= b.cost && a.arrival <= b.arrival && a.start >= b.start && a.legs <= b.legs &&
+                ++dominators >= k) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool push(const Label& label) {
+        if (labels.size() == maxLabels) return false;
+        labels.push_back(label);
+        heap.push_back(static_cast<uint32_t>(labels.size() - 1));
+        push_heap(heap.begin(), heap.end(), [this](uint32_t a, uint32_t b) { return worse(a, b); });
+        return true;
+    }
+
+public:
+    explicit ItinerarySearch(const FlightQueryEngine& e, size_t labelLimit = 1 << 16)
+        : engine(e), maxLabels(labelLimit) {
+        labels.reserve(maxLabels);
+        heap.reserve(maxLabels);
+    }
+
+    Result search(const ItineraryQuery& q) {
+        Result result;
+        const CityDictionary& cities = engine.getCities();
+        uint32_t from = cities.lookup(q.origin), to = cities.lookup(q.destination);
+        if (from == CityDictionary::UNKNOWN || to == CityDictionary::UNKNOWN || from == to || q.k == 0) return result;
+
+        labels.clear();
+        heap.clear();
+        settledHead.assign(cities.size(), NONE);
+        auto heapOrder = [this](uint32_t a, uint32_t b) { return worse(a, b); };
+
+        // First legs: departures from the origin inside the window
+        const vector<uint32_t>& first = engine.departuresFrom(from);
+        auto it = lower_bound(first.begin(), first.end(), q.departAfter,
+                              [this](uint32_t s, TimeMinutes t) { return engine.record(s).departure < t; });
+        for (; it != first.end() && engine.record(*it).departure <= q.departBefore; ++it) {
+            const FlightRecord& r = engine.record(*it);
+            if (r.freeSeats < q.seats || r.arrival - r.departure > q.maxTripMinutes) continue;
+            if (!push(Label{r.price, r.arrival, r.departure, r.destination, *it, NONE, NONE, 1})) {
+                result.truncated = true;
+                break;
+            }
+        }
+
+        while (!heap.empty() && result.itineraries.size() < q.k) {
+            pop_heap(heap.begin(), heap.end(), heapOrder);
+            uint32_t id = heap.back();
+            heap.pop_back();
+            Label current = labels[id];
+
+            if (current.city == to) {
+                Itinerary itinerary;
+                itinerary.price = current.cost;
+                itinerary.departure = current.start;
+                itinerary.arrival = current.arrival;
+                for (uint32_t l = id; l != NONE; l = labels[l].parent) {
+                    itinerary.legs.push_back(engine.record(labels[l].flight).flight);
+                }
+                reverse(itinerary.legs.begin(), itinerary.legs.end());
+                result.itineraries.push_back(move(itinerary));
+                continue;
+            }
+            if (dominated(current, q.k)) continue;
+            labels[id].nextSettled = settledHead[current.city];
+            settledHead[current.city] = id;
+            if (current.legs >= q.maxLegs) continue;
+
+            // Connections: departures in [arrival + minConnection, start + maxTrip]
+            TimeMinutes earliest = current.arrival + q.minConnection;
+            TimeMinutes deadline = current.start + q.maxTripMinutes;
+            const vector<uint32_t>& next = engine.departuresFrom(current.city);
+            auto n = lower_bound(next.begin(), next.end(), earliest,
+                                 [this](uint32_t s, TimeMinutes t) { return engine.record(s).departure < t; });
+            for (; n != next.end() && engine.record(*n).departure <= deadline; ++n) {
+                const FlightRecord& r = engine.record(*n);
+                if (r.freeSeats < q.seats || r.arrival > deadline) continue;
+                if (r.destination != to && current.legs + 1 >= q.maxLegs) continue;
+                if (visits(id, r.destination)) continue;
+                if (!push(Label{current.cost + r.price, r.arrival, current.start, r.destination, *n, id, NONE,
+                                static_cast<uint8_t>(current.legs + 1)})) {
+                    result.truncated = true;
+                    break;
+                }
+            }
+        }
+        result.labelsUsed = labels.size();
+        return result;
+    }
+
+    size_t memoryBytes() const {
+        return labels.capacity() * sizeof(Label) + heap.capacity() * sizeof(uint32_t) +
+               settledHead.capacity() * sizeof(uint32_t);
+    }
+};
+
+// Greedy algorithm for seat assignment
+class SeatAssigner {
+private:
+    vector<vector<bool>> seatMap; // true = occupied
+
+public:
+    SeatAssigner(int rows, int cols) : seatMap(rows, vector<bool>(cols, false)) {}
+
+    pair<int, int> assignBestSeat() {
+        // Priority: aisle seats, then window seats, then middle
+        vector<pair<int, int>> preferences;
+
+        int cols = seatMap[0].size();
+        for (int row = 0; row < seatMap.size(); row++) {
+            // Aisle seats (assuming 3-3-3 configuration: seats 0,2,3,5 are aisle)
+            if (!seatMap[row][0]) preferences.push_back({row, 0}); // Aisle
+            if (!seatMap[row][2]) preferences.push_back({row, 2}); // Aisle
+            if (!seatMap[row][3]) preferences.push_back({row, 3}); // Aisle
+            if (!seatMap[row][5]) preferences.push_back({row, 5}); // Aisle
+
+            // Window seats
+            if (!seatMap[row][cols-1]) preferences.push_back({row, cols-1}); // Window
+        }
+
+        if (!preferences.empty()) {
+            auto seat = preferences[0];
+            seatMap[seat.first][seat.second] = true;
+            return seat;
+        }
+
+        // Fallback: first available seat
+        for (int row = 0; row < seatMap.size(); row++) {
+            for (int col = 0; col < seatMap[row].size(); col++) {
+                if (!seatMap[row][col]) {
+                    seatMap[row][col] = true;
+                    return {row, col};
+                }
+            }
+        }
+
+        return {-1, -1}; // No seats available
+    }
+
+    void displaySeatMap() const {
+        cout << "Seat Map (O = occupied, . = available):" << endl;
+        for (int row = 0; row < seatMap.size(); row++) {
+            for (int col = 0; col < seatMap[row].size(); col++) {
+                cout << (seatMap[row][col] ? "O" : ".") << " ";
+            }
+            cout << endl;
+        }
+    }
+};
+
+// ============================================================================
+// DESIGN PATTERNS
+// ============================================================================
+
+// Factory Pattern for creating different types of flights
+class FlightFactory {
+public:
+    // Null for an unknown type or a seat count outside 1..Flight::MAX_SEATS
+    static shared_ptr<Flight> createFlight(string_view type, string fn, string dep, string arr,
+                                           const string& depTime, const string& arrTime, int seats) {
+        if (!Flight::isValidSeatCount(seats)) return nullptr;
+        if (type == "Domestic") {
+            return make_shared<DomesticFlight>(move(fn), move(dep), move(arr), depTime, arrTime, seats);
+        } else if (type == "International") {
+            return make_shared<InternationalFlight>(move(fn), move(dep), move(arr), depTime, arrTime, seats);
+        }
+        return nullptr;
+    }
+};
+
+// Strategy Pattern for different pricing strategies
+class PricingStrategy {
+public:
+    virtual double calculatePrice(double basePrice, SeatClass seatClass) = 0;
+    virtual ~PricingStrategy() = default;
+};
+
+class StandardPricing : public PricingStrategy {
+public:
+    double calculatePrice(double basePrice, SeatClass seatClass) override {
+        double multiplier = 1.0;
+        switch (seatClass) {
+            case SeatClass::Business: multiplier = 2.5; break;
+            case SeatClass::First: multiplier = 4.0; break;
+        }
+        return basePrice * multiplier;
+    }
+};
+
+class DiscountPricing : public PricingStrategy {
+public:
+    double calculatePrice(double basePrice, SeatClass seatClass) override {
+        double multiplier = 0.8; // 20% discount
+        switch (seatClass) {
+            case SeatClass::Business: multiplier = 2.0; break; // 2.0 * 0.8 = 1.6x base
+            case SeatClass::First: multiplier = 3.2; break;    // 4.0 * 0.8 = 3.2x base
+        }
+        return basePrice * multiplier;
+    }
+};
+
+// ============================================================================
+// OVERBOOKING SIMULATION (parallel Monte Carlo)
+// ============================================================================
+
+struct OverbookingConfig {
+    double overbookRate = 0.05;       // extra tickets sold, as a fraction of capacity
+    double showProbability = 0.92;    // chance each ticketed passenger turns up
+    uint64_t trialsPerFlight = 1000000;
+    unsigned threads = 0;             // 0 = one per core
+    uint64_t seed = 42;
+
+    // Overbooking can only add tickets; NaN fails both checks
+    bool isValid() const {
+        return overbookRate >= 0 && overbookRate <= 10 && showProbability >= 0 && showProbability <= 1;
+    }
+};
+
+struct OverbookingResult {
+    string flightNumber;
+    int capacity = 0;
+    int ticketsSold = 0;
+    vector<uint64_t> deniedHistogram;   // [k] = trials with k passengers denied boarding
+    vector<uint64_t> spoilageHistogram; // [k] = trials with k seats flying empty
+
+    static double mean(const vector<uint64_t>& hist) {
+        uint64_t n = 0;
+        double sum = 0;
+        for (size_t k = 0; k < hist.size(); k++) { n += hist[k]; sum += double(k) * hist[k]; }
+        return n ? sum / n : 0.0;
+    }
+
+    static int percentile(const vector<uint64_t>& hist, double p) {
+        uint64_t n = 0;
+        for (uint64_t c : hist) n += c;
+        uint64_t target = static_cast<uint64_t>(p * n), seen = 0;
+        for (size_t k = 0; k < hist.size(); k++) {
+            seen += hist[k];
+            if (seen > target) return static_cast<int>(k);
+        }
+        return static_cast<int>(hist.size()) - 1;
+    }
+
+    double probabilityOfDenial() const {
+        uint64_t n = 0;
+        for (uint64_t c : deniedHistogram) n += c;
+        return n ? double(n - deniedHistogram[0]) / n : 0.0;
+    }
+};
+
+// Trials are cut into fixed-size blocks, each with its own RNG stream derived
+// from (seed, flight, block). Threads take blocks round-robin and fill private
+// histograms that are only merged after join, so nothing mutable is shared and
+// results do not depend on the thread count.
+class OverbookingSimulator {
+private:
+    static constexpr uint64_t BLOCK_TRIALS = 1 << 16;
+
+    struct Task {
+        size_t flight;
+        uint64_t block;
+        uint64_t trials;
+    };
+
+    static uint64_t splitmix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    OverbookingConfig config;
+
+public:
+    explicit OverbookingSimulator(const OverbookingConfig& c) : config(c) {}
+
+    // Empty if the config is invalid
+    vector<OverbookingResult> run(const vector<shared_ptr<Flight>>& schedule) const {
+        if (!config.isValid()) return {};
+        vector<OverbookingResult> results(schedule.size());
+        vector<Task> tasks;
+        for (size_t f = 0; f < schedule.size(); f++) {
+            OverbookingResult& r = results[f];
+            r.flightNumber = schedule[f]->getFlightNumber();
+            r.capacity = schedule[f]->getTotalSeats();
+            r.ticketsSold = r.capacity + static_cast<int>(r.capacity * config.overbookRate + 0.5);
+            r.deniedHistogram.assign(r.ticketsSold - r.capacity + 1, 0);
+            r.spoilageHistogram.assign(r.capacity + 1, 0);
+            for (uint64_t done = 0, block = 0; done < config.trialsPerFlight; done += BLOCK_TRIALS, block++) {
+                tasks.push_back(Task{f, block, min(BLOCK_TRIALS, config.trialsPerFlight - done)});
+            }
+        }
+
+        unsigned threadCount = config.threads ? config.threads : max(1u, thread::hardware_concurrency());
+        threadCount = static_cast<unsigned>(min<size_t>(threadCount, max<size_t>(tasks.size(), 1)));
+
+        // Per-thread copies of the histograms (shape taken from results)
+        vector<vector<OverbookingResult>> partials(threadCount, results);
+        vector<thread> workers;
+        for (unsigned t = 0; t < threadCount; t++) {
+            workers.emplace_back([&, t]() {
+                vector<OverbookingResult>& local = partials[t];
+                for (size_t i = t; i < tasks.size(); i += threadCount) {
+                    const Task& task = tasks[i];
+                    OverbookingResult& r = local[task.flight];
+                    mt19937_64 rng(splitmix64(config.seed ^ splitmix64(task.flight * 0x100000001B3ULL + task.block)));
+                    binomial_distribution<int> shows(r.ticketsSold, config.showProbability);
+                    for (uint64_t trial = 0; trial < task.trials; trial++) {
+                        int showed = shows(rng);
+                        if (showed > r.capacity) r.deniedHistogram[showed - r.capacity]++;
+                        else r.deniedHistogram[0]++;
+                        r.spoilageHistogram[max(0, r.capacity - showed)]++;
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        for (const auto& local : partials) {
+            for (size_t f = 0; f < results.size(); f++) {
+                for (size_t k = 0; k < results[f].deniedHistogram.size(); k++) {
+                    results[f].deniedHistogram[k] += local[f].deniedHistogram[k];
+                }
+                for (size_t k = 0; k < results[f].spoilageHistogram.size(); k++) {
+                    results[f].spoilageHistogram[k] += local[f].spoilageHistogram[k];
+                }
+            }
+        }
+        return results;
+    }
+
+    static void printReport(const vector<OverbookingResult>& results) {
+        cout << left << setw(8) << "Flight" << right << setw(6) << "Cap" << setw(6) << "Sold"
+             << setw(10) << "P(deny)" << setw(10) << "AvgDeny" << setw(6) << "p99"
+             << setw(10) << "AvgEmpty" << setw(6) << "p50" << setw(6) << "p99" << endl;
+        for (const auto& r : results) {
+            cout << left << setw(8) << r.flightNumber << right << setw(6) << r.capacity << setw(6) << r.ticketsSold
+                 << fixed << setprecision(4) << setw(10) << r.probabilityOfDenial()
+                 << setprecision(3) << setw(10) << OverbookingResult::mean(r.deniedHistogram)
+                 << setw(6) << OverbookingResult::percentile(r.deniedHistogram, 0.99)
+                 << setw(10) << OverbookingResult::mean(r.spoilageHistogram)
+                 << setw(6) << OverbookingResult::percentile(r.spoilageHistogram, 0.50)
+                 << setw(6) << OverbookingResult::percentile(r.spoilageHistogram, 0.99) << endl;
+        }
+        cout.unsetf(ios::fixed);
+        cout << setprecision(6);
+    }
+};
+
+// ============================================================================
+// ASYNC BOOKING SERVICE: bounded queue, worker pool, batched confirms
+// ============================================================================
+
+// Front end for bursty callers. Requests go into a bounded queue (submit
+// blocks while it is full), workers drain up to maxBatch requests at a time,
+// and all confirms for the same flight in a batch become one seat update.
+// The wrapped FlightBookingSystem is not thread-safe, so workers hold
+// systemMutex while touching it; callers must not use the system directly
+// while the service is running.
+class BookingService {
+public:
+    struct Config {
+        size_t queueCapacity = 4096;
+        unsigned workers = 4;
+        size_t maxBatch = 128;
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t batches = 0;
+        uint64_t confirms = 0;
+        uint64_t seatUpdates = 0; // one per flight per batch
+    };
+
+private:
+    enum class RequestType { Create, Confirm };
+
+    struct Request {
+        RequestType type;
+        shared_ptr<Passenger> passenger;
+        string flightNumber;
+        SeatClass seatClass = SeatClass::Economy;
+        shared_ptr<Booking> booking;
+        promise<shared_ptr<Booking>> created;
+        promise<bool> confirmed;
+        function<void(bool)> onConfirmed; // used instead of the promise when set
+    };
+
+    FlightBookingSystem& system;
+    Config config;
+    mutex systemMutex;
+
+    mutex queueMutex;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    deque<Request> queue;
+    bool stopping = false;
+    vector<thread> workers;
+
+    atomic<uint64_t> requestCount{0}, batchCount{0}, confirmCount{0}, seatUpdateCount{0};
+
+    void enqueue(Request&& request) {
+        unique_lock<mutex> lock(queueMutex);
+        notFull.wait(lock, [this]() { return queue.size() < config.queueCapacity || stopping; });
+        queue.push_back(move(request));
+        lock.unlock();
+        notEmpty.notify_one();
+        requestCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    void process(vector<Request>& batch) {
+        vector<pair<shared_ptr<Booking>, bool>> createdResults;
+        vector<bool> confirmResults(batch.size(), false);
+        {
+            lock_guard<mutex> guard(systemMutex);
+            // Creates first, in arrival order
+            for (auto& r : batch) {
+                if (r.type == RequestType::Create) {
+                    r.booking = system.createBooking(r.passenger, r.flightNumber, r.seatClass);
+                }
+            }
+            // Group confirms by flight and take their seats in one update. A
+            // booking confirmed twice in one batch only asks for one seat.
+            unordered_map<Flight*, vector<size_t>> byFlight;
+            unordered_set<const Booking*> seen;
+            for (size_t i = 0; i < batch.size(); i++) {
+                const auto& r = batch[i];
+                if (r.type != RequestType::Confirm || !r.booking || !seen.insert(r.booking.get()).second) continue;
+                BookingStatus st = r.booking->getStatus();
+                if (st == BookingStatus::Pending || st == BookingStatus::Waitlisted) {
+                    byFlight[r.booking->getFlight().get()].push_back(i);
+                }
+            }
+            for (auto& [flight, indexes] : byFlight) {
+                int granted = flight->bookSeats(static_cast<int>(indexes.size()));
+                for (int k = 0; k < granted; k++) {
+                    confirmResults[indexes[k]] = system.confirmReservedSeat(*batch[indexes[k]].booking);
+                    if (!confirmResults[indexes[k]]) flight->releaseSeat(); // never strand a granted seat
+                }
+            }
+            seatUpdateCount.fetch_add(byFlight.size(), memory_order_relaxed);
+        }
+        // Complete futures outside the system lock
+        for (size_t i = 0; i < batch.size(); i++) {
+            if (batch[i].type == RequestType::Create) {
+                batch[i].created.set_value(batch[i].booking);
+            } else {
+                if (batch[i].onConfirmed) batch[i].onConfirmed(confirmResults[i]);
+                else batch[i].confirmed.set_value(confirmResults[i]);
+                confirmCount.fetch_add(1, memory_order_relaxed);
+            }
+        }
+        batchCount.fetch_add(1, memory_order_relaxed);
+    }
+
+    void workerLoop() {
+        vector<Request> batch;
+        batch.reserve(config.maxBatch);
+        while (true) {
+            {
+                unique_lock<mutex> lock(queueMutex);
+                notEmpty.wait(lock, [this]() { return !queue.empty() || stopping; });
+                if (queue.empty()) return; // stopping and drained
+                while (!queue.empty() && batch.size() < config.maxBatch) {
+                    batch.push_back(move(queue.front()));
+                    queue.pop_front();
+                }
+            }
+            notFull.notify_all();
+            process(batch);
+            batch.clear();
+        }
+    }
+
+public:
+    explicit BookingService(FlightBookingSystem& sys) : BookingService(sys, Config()) {}
+
+    BookingService(FlightBookingSystem& sys, const Config& c) : system(sys), config(c) {
+        for (unsigned i = 0; i < max(1u, config.workers); i++) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    // Finishes everything already queued, then joins the workers
+    ~BookingService() {
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    future<shared_ptr<Booking>> submitCreate(shared_ptr<Passenger> passenger, string flightNumber, SeatClass seatClass) {
+        Request r;
+        r.type = RequestType::Create;
+        r.passenger = move(passenger);
+        r.flightNumber = move(flightNumber);
+        r.seatClass = seatClass;
+        auto result = r.created.get_future();
+        enqueue(move(r));
+        return result;
+    }
+
+    future<bool> submitConfirm(shared_ptr<Booking> booking) {
+        Request r;
+        r.type = RequestType::Confirm;
+        r.booking = move(booking);
+        auto result = r.confirmed.get_future();
+        enqueue(move(r));
+        return result;
+    }
+
+    // Callback flavour; the callback runs on a worker thread
+    void submitConfirm(shared_ptr<Booking> booking, function<void(bool)> done) {
+        Request r;
+        r.type = RequestType::Confirm;
+        r.booking = move(booking);
+        r.onConfirmed = move(done);
+        enqueue(move(r));
+    }
+
+    // Runs fn with exclusive access to the wrapped system (e.g. for reports)
+    template <typename Fn>
+    auto withSystem(Fn&& fn) {
+        lock_guard<mutex> guard(systemMutex);
+        return fn(system);
+    }
+
+    Stats getStats() const {
+        Stats st;
+        st.requests = requestCount.load(memory_order_relaxed);
+        st.batches = batchCount.load(memory_order_relaxed);
+        st.confirms = confirmCount.load(memory_order_relaxed);
+        st.seatUpdates = seatUpdateCount.load(memory_order_relaxed);
+        return st;
+    }
+};
+
+#ifdef __cpp_impl_coroutine
+// ============================================================================
+// COROUTINE BOOKING WORKFLOW: create, hold seat, await payment, confirm
+// ============================================================================
+
+// Runs coroutine continuations on a few threads. A suspended workflow costs
+// only its frame, so thousands can wait on payments at once. Timers are a
+// min-heap drained by the same workers.
+class CoroutineExecutor {
+private:
+    using Clock = chrono::steady_clock;
+
+    struct Timer {
+        Clock::time_point due;
+        coroutine_handle<> handle;
+        bool operator>(const Timer& o) const { return due > o.due; }
+    };
+
+    mutex lock;
+    condition_variable wake;
+    deque<coroutine_handle<>> ready;
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+    bool stopping = false;
+    vector<thread> workers;
+
+    void workerLoop() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            auto now = Clock::now();
+            while (!timers.empty() && timers.top().due <= now) {
+                ready.push_back(timers.top().handle);
+                timers.pop();
+            }
+            if (!ready.empty()) {
+                coroutine_handle<> h = ready.front();
+                ready.pop_front();
+                guard.unlock();
+                h.resume();
+                guard.lock();
+                continue;
+            }
+            if (stopping) return;
+            if (timers.empty()) {
+                wake.wait(guard);
+            } else {
+                wake.wait_until(guard, timers.top().due);
+            }
+        }
+    }
+
+public:
+    explicit CoroutineExecutor(unsigned threads = 2) {
+        for (unsigned i = 0; i < max(1u, threads); i++) workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    // Finishes everything runnable; coroutines still waiting on a timer are destroyed
+    ~CoroutineExecutor() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) t.join();
+        while (!timers.empty()) {
+            timers.top().handle.destroy();
+            timers.pop();
+        }
+    }
+
+    void post(coroutine_handle<> h) {
+        {
+            lock_guard<mutex> guard(lock);
+            ready.push_back(h);
+        }
+        wake.notify_one();
+    }
+
+    void postAt(coroutine_handle<> h, Clock::time_point due) {
+        bool earliest;
+        {
+            lock_guard<mutex> guard(lock);
+            earliest = timers.empty() || due < timers.top().due;
+            timers.push(Timer{due, h});
+        }
+        if (earliest) wake.notify_one();
+    }
+
+    // co_await executor.schedule(): continue on a worker thread
+    auto schedule() {
+        struct Awaiter {
+            CoroutineExecutor& executor;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { executor.post(h); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    // co_await executor.sleepFor(d): resume on a worker after d
+    auto sleepFor(chrono::nanoseconds delay) {
+        struct Awaiter {
+            CoroutineExecutor& executor;
+            Clock::time_point due;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) { executor.postAt(h, due); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, Clock::now() + delay};
+    }
+
+    size_t threadCount() const { return workers.size(); }
+};
+
+// Fire-and-forget coroutine: starts immediately, frees its frame when done
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { terminate(); }
+    };
+};
+
+// Local stand-in for the payment / fraud-check provider: answers after a
+// random latency in [minLatency, maxLatency] and declines a fixed share.
+class PaymentService {
+public:
+    struct Config {
+        chrono::microseconds minLatency{20000};
+        chrono::microseconds maxLatency{80000};
+        double declineRate = 0.05;
+    };
+
+private:
+    CoroutineExecutor& executor;
+    Config config;
+    mutex rngMutex;
+    mt19937_64 rng{2024};
+
+public:
+    PaymentService(CoroutineExecutor& ex, const Config& c) : executor(ex), config(c) {}
+
+    // co_await payments.authorize(id, amount) -> approved?
+    auto authorize(BookingId id, double amount) {
+        struct Awaiter {
+            PaymentService& service;
+            BookingId id;
+            double amount;
+            bool approved = false;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(coroutine_handle<> h) {
+                chrono::microseconds latency;
+                {
+                    lock_guard<mutex> guard(service.rngMutex);
+                    auto span = (service.config.maxLatency - service.config.minLatency).count();
+                    latency = service.config.minLatency + chrono::microseconds(span > 0 ? service.rng() % (span + 1) : 0);
+                    approved = amount > 0 && double(service.rng() % 10000) >= service.config.declineRate * 10000;
+                }
+                service.executor.postAt(h, chrono::steady_clock::now() + latency);
+            }
+            bool await_resume() const noexcept { return approved; }
+        };
+        return Awaiter{*this, id, amount};
+    }
+};
+
+// The booking workflow as one coroutine per booking. The seat is held through
+// the system before payment so it cannot be sold twice, then either confirmed
+// or released. A booking cancelled while its payment is pending gives the
+// seat back at once. System calls are serialized by one mutex; no thread
+// blocks while a payment is pending.
+class BookingWorkflow {
+public:
+    enum class Outcome { Confirmed, PaymentDeclined, SoldOut, NoSuchFlight, Cancelled, Count };
+
+    struct Stats {
+        uint64_t started = 0;
+        uint64_t finished = 0;
+        uint64_t peakInFlight = 0;
+        array<uint64_t, static_cast<size_t>(Outcome::Count)> outcomes{};
+    };
+
+private:
+    FlightBookingSystem& system;
+    CoroutineExecutor& executor;
+    PaymentService& payments;
+    mutex systemMutex;
+
+    mutex statsMutex;
+    condition_variable idle;
+    Stats stats;
+
+    // Notifies under the lock: once waitIdle returns, the workflow may be destroyed
+    void finish(Outcome outcome) {
+        lock_guard<mutex> guard(statsMutex);
+        stats.finished++;
+        stats.outcomes[static_cast<size_t>(outcome)]++;
+        idle.notify_all();
+    }
+
+    DetachedTask run(shared_ptr<Passenger> passenger, string flightNumber, SeatClass seatClass,
+                     function<void(Outcome, shared_ptr<Booking>)> done) {
+        co_await executor.schedule();
+
+        shared_ptr<Booking> booking;
+        bool held = false;
+        {
+            lock_guard<mutex> guard(systemMutex);
+            booking = system.createBooking(passenger, flightNumber, seatClass);
+            if (booking) held = system.holdSeat(booking->getBookingId());
+            if (booking && !held) system.cancelBooking(booking->getBookingId());
+        }
+        Outcome outcome = !booking ? Outcome::NoSuchFlight : !held ? Outcome::SoldOut : Outcome::Confirmed;
+
+        if (held) {
+            bool approved = co_await payments.authorize(booking->getBookingId(), booking->getTotalPrice());
+            lock_guard<mutex> guard(systemMutex);
+            if (!approved) {
+                system.releaseHeldSeat(booking->getBookingId());
+                system.cancelBooking(booking->getBookingId());
+                outcome = Outcome::PaymentDeclined;
+            } else if (!system.confirmHeldSeat(booking->getBookingId())) {
+                outcome = Outcome::Cancelled;
+            }
+        }
+        if (done) done(outcome, booking);
+        finish(outcome);
+    }
+
+public:
+    BookingWorkflow(FlightBookingSystem& sys, CoroutineExecutor& ex, PaymentService& pay)
+        : system(sys), executor(ex), payments(pay) {}
+
+    // Starts a workflow and returns at once; done runs on an executor thread
+    void start(shared_ptr<Passenger> passenger, string flightNumber, SeatClass seatClass,
+               function<void(Outcome, shared_ptr<Booking>)> done = nullptr) {
+        {
+            lock_guard<mutex> guard(statsMutex);
+            stats.started++;
+            stats.peakInFlight = max(stats.peakInFlight, stats.started - stats.finished);
+        }
+        run(move(passenger), move(flightNumber), seatClass, move(done));
+    }
+
+    void waitIdle() {
+        unique_lock<mutex> guard(statsMutex);
+        idle.wait(guard, [this]() { return stats.finished == stats.started; });
+    }
+
+    // Runs fn(FlightBookingSystem&) under the workflow's system lock
+    template <typename Fn>
+    auto withSystem(Fn&& fn) {
+        lock_guard<mutex> guard(systemMutex);
+        return fn(system);
+    }
+
+    Stats getStats() {
+        lock_guard<mutex> guard(statsMutex);
+        return stats;
+    }
+
+    static const char* outcomeName(Outcome o) {
+        static const char* names[] = {"confirmed", "payment_declined", "sold_out", "no_such_flight", "cancelled"};
+        return names[static_cast<size_t>(o)];
+    }
+};
+#endif
+
+// ============================================================================
+// MANIFEST EXPORT: bookings formatted in parallel, written in order
+// ============================================================================
+
+// Each thread formats one contiguous slice of the bookings into its own
+// buffer (the same text displayAllBookings prints per booking); the buffers
+// are then written back to back, so the output matches a sequential export.
+class ManifestExporter {
+private:
+    unsigned threads;
+
+    static void formatRange(const vector<shared_ptr<Booking>>& bookings, size_t begin, size_t end, string& buffer) {
+        ostringstream out;
+        for (size_t i = begin; i < end; i++) {
+            bookings[i]->printBooking(out);
+            out << "------------------------\n";
+        }
+        buffer = move(out).str();
+    }
+
+public:
+    explicit ManifestExporter(unsigned threadCount = 0)
+        : threads(threadCount ? threadCount : max(1u, thread::hardware_concurrency())) {}
+
+    // One buffer per partition, in booking order
+    vector<string> format(const vector<shared_ptr<Booking>>& bookings) const {
+        size_t parts = min<size_t>(threads, max<size_t>(bookings.size(), 1));
+        vector<string> buffers(parts);
+        vector<thread> workers;
+        for (size_t p = 1; p < parts; p++) {
+            workers.emplace_back(formatRange, cref(bookings), bookings.size() * p / parts,
+                                 bookings.size() * (p + 1) / parts, ref(buffers[p]));
+        }
+        formatRange(bookings, 0, bookings.size() / parts, buffers[0]);
+        for (auto& t : workers) t.join();
+        return buffers;
+    }
+
+    // Portable path: one write per buffer
+    size_t write(ostream& out, const vector<shared_ptr<Booking>>& bookings) const {
+        size_t bytes = 0;
+        for (const string& buffer : format(bookings)) {
+            out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+            bytes += buffer.size();
+        }
+        return bytes;
+    }
+
+#ifdef __linux__
+    // Gathers all buffers into writev calls; returns bytes written or -1
+    ssize_t write(int fd, const vector<shared_ptr<Booking>>& bookings) const {
+        vector<string> buffers = format(bookings);
+        vector<iovec> pending;
+        for (string& buffer : buffers) {
+            if (!buffer.empty()) pending.push_back(iovec{&buffer[0], buffer.size()});
+        }
+        ssize_t total = 0;
+        size_t first = 0;
+        while (first < pending.size()) {
+            int count = static_cast<int>(min<size_t>(pending.size() - first, IOV_MAX));
+            ssize_t n = ::writev(fd, &pending[first], count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            total += n;
+            // Skip fully written buffers, trim a partially written one
+            while (first < pending.size() && static_cast<size_t>(n) >= pending[first].iov_len) {
+                n -= static_cast<ssize_t>(pending[first].iov_len);
+                first++;
+            }
+            if (n > 0) {
+                pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + n;
+                pending[first].iov_len -= static_cast<size_t>(n);
+            }
+        }
+        return total;
+    }
+#endif
+};
+
+// ============================================================================
+// ANALYTICS: columnar projection + parallel filter / group-by / aggregates
+// ============================================================================
+
+// Struct-of-arrays copy of the bookings and flights, taken once per batch of
+// reports. Categorical fields are dense integer codes, so group-by keys index
+// straight into aggregate arrays.
+struct ColumnarProjection {
+    CityDictionary cities;
+    vector<pair<uint32_t, uint32_t>> routes; // route code -> (origin, destination)
+
+    // One row per flight, indexed by inventory slot
+    vector<uint32_t> flightRoute;
+    vector<int32_t> flightDepartureHour; // 0-23
+    vector<double> flightSeatsSold;
+    vector<double> flightTotalSeats;
+
+    // One row per booking
+    vector<uint32_t> bookingFlight;
+    vector<uint32_t> bookingRoute; // denormalized from the flight
+    vector<uint8_t> bookingClass;
+    vector<uint8_t> bookingStatus;
+    vector<double> bookingPrice;
+
+    static ColumnarProjection build(const vector<shared_ptr<Flight>>& flights,
+                                    const vector<shared_ptr<Booking>>& bookings) {
+        ColumnarProjection p;
+        unordered_map<uint64_t, uint32_t> routeCodes;
+        size_t nf = flights.size();
+        p.flightRoute.resize(nf);
+        p.flightDepartureHour.resize(nf);
+        p.flightSeatsSold.resize(nf);
+        p.flightTotalSeats.resize(nf);
+        for (size_t i = 0; i < nf; i++) {
+            const Flight& f = *flights[i];
+            uint32_t origin = p.cities.intern(f.getDepartureCity());
+            uint32_t destination = p.cities.intern(f.getArrivalCity());
+            auto it = routeCodes.emplace((uint64_t(origin) << 32) | destination, static_cast<uint32_t>(p.routes.size()));
+            if (it.second) p.routes.emplace_back(origin, destination);
+            TimeMinutes dep = f.getDepartureMinutes();
+            p.flightRoute[i] = it.first->second;
+            p.flightDepartureHour[i] = (dep - dayOf(dep) * MINUTES_PER_DAY) / 60;
+            p.flightSeatsSold[i] = f.getTotalSeats() - f.getAvailableSeats();
+            p.flightTotalSeats[i] = f.getTotalSeats();
+        }
+
+        size_t nb = bookings.size();
+        p.bookingFlight.resize(nb);
+        p.bookingRoute.resize(nb);
+        p.bookingClass.resize(nb);
+        p.bookingStatus.resize(nb);
+        p.bookingPrice.resize(nb);
+        for (size_t i = 0; i < nb; i++) {
+            const Booking& b = *bookings[i];
+            uint32_t slot = b.getFlight()->getInventorySlot();
+            p.bookingFlight[i] = slot;
+            p.bookingRoute[i] = p.flightRoute[slot];
+            p.bookingClass[i] = static_cast<uint8_t>(b.getSeatClass());
+            p.bookingStatus[i] = static_cast<uint8_t>(b.getStatus());
+            p.bookingPrice[i] = b.getTotalPrice();
+        }
+        return p;
+    }
+
+    string routeName(uint32_t route) const {
+        return cities.name(routes[route].first) + "-" + cities.name(routes[route].second);
+    }
+};
+
+// Operators over equal-length columns. A Mask is one byte per row (0 or 1)
+// so filters and aggregates are branch-free loops the compiler vectorizes.
+// Each operator splits rows into one contiguous range per thread; group-by
+// threads aggregate into private arrays that are summed afterwards.
+class AnalyticsEngine {
+public:
+    using Mask = vector<uint8_t>;
+
+    struct Groups {
+        vector<double> sum;
+        vector<uint64_t> count;
+
+        double avg(size_t g) const { return count[g] ? sum[g] / double(count[g]) : 0.0; }
+        size_t size() const { return sum.size(); }
+    };
+
+    explicit AnalyticsEngine(unsigned threadCount = 0)
+        : threads(threadCount ? threadCount : max(1u, thread::hardware_concurrency())) {}
+
+    // mask[i] = pred(column[i])
+    template <typename T, typename Pred>
+    Mask filter(const vector<T>& column, Pred pred) const {
+        Mask mask(column.size());
+        parallelFor(column.size(), [&](size_t begin, size_t end, unsigned) {
+            const T* in = column.data();
+            uint8_t* out = mask.data();
+            for (size_t i = begin; i < end; i++) out[i] = pred(in[i]) ? 1 : 0;
+        });
+        return mask;
+    }
+
+    Mask both(const Mask& a, const Mask& b) const {
+        Mask mask(a.size());
+        parallelFor(a.size(), [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) mask[i] = a[i] & b[i];
+        });
+        return mask;
+    }
+
+    // Composite group key: a * bCardinality + b
+    template <typename A, typename B>
+    vector<uint32_t> combineKeys(const vector<A>& a, const vector<B>& b, uint32_t bCardinality) const {
+        vector<uint32_t> keys(a.size());
+        parallelFor(a.size(), [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++) keys[i] = uint32_t(a[i]) * bCardinality + uint32_t(b[i]);
+        });
+        return keys;
+    }
+
+    // Sum and count of values per key in [0, groups); rows with mask 0 are
+    // skipped. values may be null to only count.
+    template <typename K>
+    Groups groupBy(const vector<K>& keys, size_t groups, const vector<double>* values = nullptr,
+                   const Mask* mask = nullptr) const {
+        vector<Groups> partial(threads);
+        parallelFor(keys.size(), [&](size_t begin, size_t end, unsigned t) {
+            Groups& g = partial[t];
+            g.sum.assign(groups, 0.0);
+            g.count.assign(groups, 0);
+            const K* k = keys.data();
+            const uint8_t* m = mask ? mask->data() : nullptr;
+            const double* v = values ? values->data() : nullptr;
+            for (size_t i = begin; i < end; i++) {
+                uint8_t take = m ? m[i] : 1;
+                g.sum[k[i]] += v ? v[i] * take : 0.0;
+                g.count[k[i]] += take;
+            }
+        });
+        Groups result;
+        result.sum.assign(groups, 0.0);
+        result.count.assign(groups, 0);
+        for (const Groups& g : partial) {
+            if (g.sum.empty()) continue;
+            for (size_t i = 0; i < groups; i++) {
+                result.sum[i] += g.sum[i];
+                result.count[i] += g.count[i];
+            }
+        }
+        return result;
+    }
+
+    double sum(const vector<double>& values, const Mask* mask = nullptr) const {
+        vector<double> partial(threads, 0.0);
+        parallelFor(values.size(), [&](size_t begin, size_t end, unsigned t) {
+            double total = 0.0;
+            if (mask) {
+                for (size_t i = begin; i < end; i++) total += values[i] * (*mask)[i];
+            } else {
+                for (size_t i = begin; i < end; i++) total += values[i];
+            }
+            partial[t] = total;
+        });
+        double total = 0.0;
+        for (double x : partial) total += x;
+        return total;
+    }
+
+    uint64_t count(const Mask& mask) const {
+        vector<uint64_t> partial(threads, 0);
+        parallelFor(mask.size(), [&](size_t begin, size_t end, unsigned t) {
+            uint64_t c = 0;
+            for (size_t i = begin; i < end; i++) c += mask[i];
+            partial[t] = c;
+        });
+        uint64_t total = 0;
+        for (uint64_t c : partial) total += c;
+        return total;
+    }
+
+    double avg(const vector<double>& values, const Mask* mask = nullptr) const {
+        uint64_t n = mask ? count(*mask) : values.size();
+        return n ? sum(values, mask) / double(n) : 0.0;
+    }
+
+    unsigned getThreads() const { return threads; }
+
+private:
+    // Small inputs are not worth a thread
+    static constexpr size_t MIN_ROWS_PER_THREAD = 16384;
+
+    unsigned threads;
+
+    template <typename Fn>
+    void parallelFor(size_t n, Fn&& fn) const {
+        unsigned parts = static_cast<unsigned>(min<size_t>(threads, max<size_t>(1, n / MIN_ROWS_PER_THREAD)));
+        vector<thread> workers;
+        for (unsigned t = 1; t < parts; t++) {
+            workers.emplace_back([&, t]() { fn(n * t / parts, n * (t + 1) / parts, t); });
+        }
+        fn(0, n / parts, 0);
+        for (auto& w : workers) w.join();
+    }
+};
+
+// ============================================================================
+// TRACE REPLAY: re-executes a recorded trace and times every operation
+// ============================================================================
+
+// Replays against a fresh FlightBookingSystem, either as fast as possible or
+// sleeping to reproduce the recorded gaps between calls. Each traced flight
+// is also added to a RouteOptimizer (callers fill theirs the same way), and
+// query cursors are drained, as the benchmark does.
+class TraceReplayer {
+private:
+    struct OpStats {
+        LatencyHistogram latency;
+    };
+
+    string path;
+    array<OpStats, static_cast<size_t>(TraceOp::Count)> stats;
+    uint64_t records = 0;
+    double recordedSeconds = 0;
+    double replaySeconds = 0;
+    uint64_t seatsSold = 0; // across all flights once replayed, to compare with the recorded run
+    bool paced = false;
+
+    static double getDouble(VarintReader& r) {
+        double v = 0;
+        string_view raw = r.bytes(sizeof(double));
+        if (raw.size() == sizeof(double)) memcpy(&v, raw.data(), sizeof(v));
+        return v;
+    }
+
+    static TimeMinutes getTime(VarintReader& r) { return static_cast<TimeMinutes>(unzigzag(r.varint())); }
+
+public:
+    explicit TraceReplayer(string tracePath) : path(move(tracePath)) {}
+
+    // False if the file is missing or not a trace
+    bool run(bool withPacing) {
+        paced = withPacing;
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) return false;
+        vector<uint8_t> data;
+        uint8_t chunk[1 << 16];
+        for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) data.insert(data.end(), chunk, chunk + n);
+        fclose(file);
+        if (data.size() < 8 || memcmp(data.data(), TraceRecorder::MAGIC, 8) != 0) return false;
+
+        FlightBookingSystem system;
+        RouteOptimizer optimizer;
+        vector<string> flightNumbers;
+        vector<shared_ptr<Passenger>> passengers;
+        vector<BookingId> bookingIds;
+        auto flightOf = [&](VarintReader& r) {
+            uint64_t ordinal = r.varint();
+            if (ordinal == 0) return string(r.text());
+            return ordinal <= flightNumbers.size() ? flightNumbers[ordinal - 1] : string();
+        };
+        auto bookingOf = [&](VarintReader& r) {
+            uint64_t ordinal = r.varint();
+            return ordinal && ordinal <= bookingIds.size() ? bookingIds[ordinal - 1] : BookingId(0);
+        };
+
+        VarintReader r{data.data() + 8, data.data() + data.size()};
+        auto start = chrono::steady_clock::now();
+        uint64_t recordedNanos = 0;
+        while (r.p < r.end) {
+            TraceOp op = static_cast<TraceOp>(*r.p++);
+            recordedNanos += r.varint();
+            if (paced) this_thread::sleep_until(start + chrono::nanoseconds(recordedNanos));
+
+            auto opStart = chrono::steady_clock::now();
+            switch (op) {
+                case TraceOp::AddFlight: {
+                    string type(r.text()), number(r.text()), from(r.text()), to(r.text());
+                    TimeMinutes departure = getTime(r), arrival = getTime(r);
+                    uint64_t seats = r.varint();
+                    if (seats > static_cast<uint64_t>(Flight::MAX_SEATS)) return false;
+                    auto flight = FlightFactory::createFlight(type, number, from, to, formatTime(departure),
+                                                              formatTime(arrival), static_cast<int>(seats));
+                    if (!flight || !system.addFlight(flight)) return false;
+                    optimizer.addFlightRoute(from, to, flight->getFare());
+                    flightNumbers.push_back(number);
+                    break;
+                }
+                case TraceOp::DefinePassenger: {
+                    string name(r.text()), passport(r.text()), contact(r.text()), email(r.text());
+                    passengers.push_back(make_shared<Passenger>(name, passport, contact, email));
+                    break;
+                }
+                case TraceOp::CreateBooking: {
+                    uint64_t passenger = r.varint();
+                    string number = flightOf(r);
+                    if (r.p >= r.end || *r.p > static_cast<uint8_t>(SeatClass::First)) return false;
+                    SeatClass seatClass = static_cast<SeatClass>(*r.p++);
+                    if (passenger >= passengers.size()) return false;
+                    opStart = chrono::steady_clock::now();
+                    auto booking = system.createBooking(passengers[passenger], number, seatClass);
+                    bookingIds.push_back(booking ? booking->getBookingId() : 0);
+                    break;
+                }
+                case TraceOp::ConfirmOrWaitlist:
+                    system.confirmOrWaitlist(bookingOf(r));
+                    break;
+                case TraceOp::CancelBooking:
+                    system.cancelBooking(bookingOf(r));
+                    break;
+                case TraceOp::ConfirmReservedSeat: {
+                    // The caller (e.g. the batched service) took the seat; a failed confirm gave it back
+                    auto booking = system.findBooking(bookingOf(r));
+                    if (booking && booking->getFlight()->bookSeat() && !system.confirmReservedSeat(*booking)) {
+                        booking->getFlight()->releaseSeat();
+                    }
+                    break;
+                }
+                case TraceOp::HoldSeat:
+                    system.holdSeat(bookingOf(r));
+                    break;
+                case TraceOp::ConfirmHeldSeat:
+                    system.confirmHeldSeat(bookingOf(r));
+                    break;
+                case TraceOp::ReleaseHeldSeat:
+                    system.releaseHeldSeat(bookingOf(r));
+                    break;
+                case TraceOp::AssignSeat: {
+                    BookingId id = bookingOf(r);
+                    if (r.p >= r.end || *r.p > static_cast<uint8_t>(SeatPreference::Aisle)) return false;
+                    SeatPreference pref = static_cast<SeatPreference>(*r.p++);
+                    opStart = chrono::steady_clock::now();
+                    system.assignSeat(id, pref);
+                    break;
+                }
+                case TraceOp::SetFare: {
+                    auto flight = system.findFlight(flightOf(r));
+                    double fare = getDouble(r);
+                    opStart = chrono::steady_clock::now();
+                    if (flight) flight->setFare(fare);
+                    break;
+                }
+                case TraceOp::FindFlightByDestination: {
+                    string destination(r.text());
+                    opStart = chrono::steady_clock::now();
+                    system.findFlightByDestination(destination);
+                    break;
+                }
+                case TraceOp::FindFlightsByPriceRange: {
+                    double low = getDouble(r), high = getDouble(r);
+                    system.findFlightsByPriceRange(low, high);
+                    break;
+                }
+                case TraceOp::FindCheapestFlight:
+                    system.findCheapestFlight(getDouble(r));
+                    break;
+                case TraceOp::Query: {
+                    FlightQuery q;
+                    q.origin = string(r.text());
+                    q.destination = string(r.text());
+                    q.departAfter = getTime(r);
+                    q.departBefore = getTime(r);
+                    q.minPrice = getDouble(r);
+                    q.maxPrice = getDouble(r);
+                    q.minFreeSeats = static_cast<int>(unzigzag(r.varint()));
+                    opStart = chrono::steady_clock::now();
+                    auto cursor = system.query(q);
+                    const Flight* page[32];
+                    while (cursor.nextPage(page, 32)) {}
+                    break;
+                }
+                case TraceOp::FindFlightsDepartingBetween: {
+                    string origin(r.text());
+                    TimeMinutes from = getTime(r), to = getTime(r);
+                    opStart = chrono::steady_clock::now();
+                    system.findFlightsDepartingBetween(origin, from, to);
+                    break;
+                }
+                case TraceOp::FindCheapestRoute: {
+                    string from(r.text()), to(r.text());
+                    opStart = chrono::steady_clock::now();
+                    optimizer.findCheapestRoute(from, to);
+                    break;
+                }
+                default:
+                    return false; // unknown record: corrupt or newer trace
+            }
+            stats[static_cast<size_t>(op)].latency.record(
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - opStart).count());
+            records++;
+        }
+        replaySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        recordedSeconds = recordedNanos / 1e9;
+        seatsSold = 0;
+        for (const auto& f : system.getFlights()) seatsSold += f->getTotalSeats() - f->getAvailableSeats();
+        return true;
+    }
+
+    uint64_t getSeatsSold() const { return seatsSold; }
+
+    void writeJson(ostream& out) const {
+        out << "{\n  \"trace\": \"" << path << "\", \"records\": " << records << ", \"paced\": " << (paced ? "true" : "false")
+            << ", \"recorded_seconds\": " << recordedSeconds << ", \"replay_seconds\": " << replaySeconds
+            << ", \"seats_sold\": " << seatsSold << ",\n  \"operations\": {";
+        bool first = true;
+        for (size_t op = 1; op < stats.size(); op++) {
+            const LatencyHistogram& h = stats[op].latency;
+            if (h.count() == 0 || static_cast<TraceOp>(op) == TraceOp::DefinePassenger) continue;
+            out << (first ? "" : ",") << "\n    \"" << traceOpName(static_cast<TraceOp>(op)) << "\": {\"count\": "
+                << h.count() << ", \"mean_ns\": " << uint64_t(h.mean()) << ", \"p50_ns\": " << h.percentile(0.50)
+                << ", \"p99_ns\": " << h.percentile(0.99) << ", \"max_ns\": " << h.maxNanos() << "}";
+            first = false;
+        }
+        out << "\n  }\n}" << endl;
+    }
+};
+
+// ============================================================================
+// BENCHMARK: synthetic schedules, passengers and Zipf-skewed request mixes
+// ============================================================================
+
+// Samples ranks 0..n-1 with P(k) proportional to 1 / (k+1)^skew
+class ZipfSampler {
+private:
+    vector<double> cdf;
+
+public:
+    ZipfSampler(size_t n, double skew) : cdf(max<size_t>(n, 1)) {
+        double total = 0;
+        for (size_t k = 0; k < cdf.size(); k++) {
+            total += 1.0 / pow(double(k + 1), skew);
+            cdf[k] = total;
+        }
+        for (double& c : cdf) c /= total;
+    }
+
+    size_t operator()(mt19937_64& rng) const {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return min<size_t>(lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin(), cdf.size() - 1);
+    }
+};
+
+struct WorkloadConfig {
+    size_t flights = 2000;
+    size_t passengers = 20000;
+    size_t operations = 200000;
+    double skew = 1.0;  // Zipf exponent for flight / city popularity
+    int days = 7;       // schedule spans this many days from the epoch
+    uint64_t seed = 7;
+};
+
+// Builds a reproducible schedule over real city names and drives the public
+// FlightBookingSystem API with a fixed operation mix.
+class WorkloadGenerator {
+private:
+    static const vector<string>& domesticCities() {
+        static const vector<string> cities = {
+            "Delhi", "Mumbai", "Bangalore", "Chennai", "Kolkata", "Hyderabad", "Pune", "Ahmedabad",
+            "Jaipur", "Lucknow", "Kochi", "Goa", "Indore", "Bhopal", "Patna", "Guwahati",
+            "Chandigarh", "Nagpur", "Srinagar", "Varanasi"};
+        return cities;
+    }
+
+    static const vector<string>& internationalCities() {
+        static const vector<string> cities = {
+            "New York", "London", "Dubai", "Singapore", "Tokyo", "Paris", "Frankfurt", "Sydney",
+            "Toronto", "Hong Kong", "Bangkok", "Doha"};
+        return cities;
+    }
+
+    WorkloadConfig config;
+    mt19937_64 rng;
+
+public:
+    explicit WorkloadGenerator(const WorkloadConfig& c) : config(c), rng(c.seed) {}
+
+    mt19937_64& random() { return rng; }
+
+    // Hubs come first in the city lists, so Zipf over the list skews traffic towards them
+    vector<shared_ptr<Flight>> makeSchedule() {
+        const auto& domestic = domesticCities();
+        const auto& international = internationalCities();
+        ZipfSampler domesticPick(domestic.size(), config.skew);
+        ZipfSampler internationalPick(international.size(), config.skew);
+        vector<shared_ptr<Flight>> schedule;
+        schedule.reserve(config.flights);
+        for (size_t i = 0; i < config.flights; i++) {
+            bool isInternational = rng() % 5 == 0;
+            string from = domestic[domesticPick(rng)];
+            string to = isInternational ? international[internationalPick(rng)] : domestic[domesticPick(rng)];
+            while (to == from) to = domestic[rng() % domestic.size()];
+            TimeMinutes departure = static_cast<TimeMinutes>(rng() % config.days) * MINUTES_PER_DAY +
+                                    static_cast<TimeMinutes>(rng() % (24 * 12)) * 5;
+            int duration = isInternational ? 360 + static_cast<int>(rng() % 600) : 60 + static_cast<int>(rng() % 180);
+            int seats = isInternational ? 250 + static_cast<int>(rng() % 150) : 120 + static_cast<int>(rng() % 80);
+            schedule.push_back(FlightFactory::createFlight(isInternational ? "International" : "Domestic",
+                                                           "FX" + to_string(1000 + i), from, to,
+                                                           formatTime(departure), formatTime(departure + duration), seats));
+        }
+        return schedule;
+    }
+
+    vector<shared_ptr<Passenger>> makePassengers() {
+        static const char* first[] = {"Aarav", "Diya", "Kabir", "Meera", "Rohan", "Sara", "Vivaan", "Anika"};
+        static const char* last[] = {"Sharma", "Iyer", "Khan", "Das", "Patel", "Reddy", "Singh", "Nair"};
+        vector<shared_ptr<Passenger>> people;
+        people.reserve(config.passengers);
+        for (size_t i = 0; i < config.passengers; i++) {
+            string name = string(first[rng() % 8]) + " " + last[rng() % 8];
+            string passport = "P" + to_string(1000000 + i);
+            people.push_back(make_shared<Passenger>(name, passport, "+91-9" + to_string(100000000 + rng() % 900000000),
+                                                    "user" + to_string(i) + "@example.com"));
+        }
+        return people;
+    }
+
+    const WorkloadConfig& getConfig() const { return config; }
+};
+
+class BookingBenchmark {
+private:
+    struct OpStats {
+        LatencyHistogram latency;
+        double seconds = 0;
+    };
+
+    WorkloadConfig config;
+    vector<pair<string, OpStats>> stats; // insertion ordered for stable JSON output
+    QueryCacheStats cacheStats;
+    size_t autocompleteTerms = 0, autocompleteBytes = 0;
+    TraceRecorder* tracer = nullptr;
+
+    OpStats& statsFor(const string& op) {
+        for (auto& entry : stats) {
+            if (entry.first == op) return entry.second;
+        }
+        stats.emplace_back(op, OpStats());
+        return stats.back().second;
+    }
+
+    template <typename Fn>
+    void timed(const string& op, Fn&& fn) {
+        OpStats& st = statsFor(op);
+        auto start = chrono::steady_clock::now();
+        fn();
+        auto elapsed = chrono::steady_clock::now() - start;
+        st.latency.record(chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+        st.seconds += chrono::duration<double>(elapsed).count();
+    }
+
+public:
+    explicit BookingBenchmark(const WorkloadConfig& c) : config(c) {}
+
+    // Records the workload's API calls (null: no recording)
+    void setTracer(TraceRecorder* recorder) { tracer = recorder; }
+
+    void run() {
+        WorkloadGenerator generator(config);
+        mt19937_64& rng = generator.random();
+        FlightBookingSystem system;
+        RouteOptimizer optimizer;
+        system.attachTracer(tracer);
+        optimizer.attachTracer(tracer);
+
+        auto schedule = generator.makeSchedule();
+        auto people = generator.makePassengers();
+        for (const auto& flight : schedule) {
+            timed("addFlight", [&]() { system.addFlight(flight); });
+            optimizer.addFlightRoute(flight->getDepartureCity(), flight->getArrivalCity(), flight->getFare());
+        }
+
+        // Popularity ranks are mapped onto shuffled flights / passengers
+        vector<size_t> flightRank(schedule.size()), passengerRank(people.size());
+        for (size_t i = 0; i < flightRank.size(); i++) flightRank[i] = i;
+        for (size_t i = 0; i < passengerRank.size(); i++) passengerRank[i] = i;
+        shuffle(flightRank.begin(), flightRank.end(), rng);
+        shuffle(passengerRank.begin(), passengerRank.end(), rng);
+        ZipfSampler flightPick(schedule.size(), config.skew);
+        ZipfSampler passengerPick(people.size(), config.skew * 0.5);
+        uniform_int_distribution<int> percent(0, 99);
+
+        for (size_t op = 0; op < config.operations; op++) {
+            int roll = percent(rng);
+            const auto& flight = schedule[flightRank[flightPick(rng)]];
+            if (roll < 40) {
+                const auto& passenger = people[passengerRank[passengerPick(rng)]];
+                SeatClass sc = roll < 32 ? SeatClass::Economy : (roll < 38 ? SeatClass::Business : SeatClass::First);
+                shared_ptr<Booking> booking;
+                timed("createBooking", [&]() { booking = system.createBooking(passenger, flight->getFlightNumber(), sc); });
+                if (booking) timed("confirmOrWaitlist", [&]() { system.confirmOrWaitlist(booking->getBookingId()); });
+            } else if (roll < 65) {
+                string city = flight->getArrivalCity();
+                timed("findFlightByDestination", [&]() { system.findFlightByDestination(city); });
+            } else if (roll < 80) {
+                double low = 1000.0 * (rng() % 30);
+                timed("findFlightsByPriceRange", [&]() { system.findFlightsByPriceRange(low, low + 10000); });
+            } else if (roll < 90) {
+                FlightQuery q;
+                q.origin = flight->getDepartureCity();
+                q.departAfter = static_cast<TimeMinutes>(rng() % (config.days * MINUTES_PER_DAY));
+                q.departBefore = q.departAfter + 240;
+                q.minFreeSeats = 1;
+                timed("query", [&]() {
+                    auto cursor = system.query(q);
+                    const Flight* page[32];
+                    while (cursor.nextPage(page, 32)) {}
+                });
+            } else if (roll < 95) {
+                double budget = roll % 2 ? 6000.0 : 30000.0;
+                timed("findCheapestFlight", [&]() { system.findCheapestFlight(budget); });
+            } else {
+                string from = flight->getDepartureCity();
+                string to = schedule[flightRank[flightPick(rng)]]->getArrivalCity();
+                timed("findCheapestRoute", [&]() { optimizer.findCheapestRoute(from, to); });
+            }
+        }
+
+        for (int i = 0; i < 10; i++) {
+            vector<shared_ptr<Flight>> flightList = system.getFlights();
+            timed("sortFlightsByPrice", [&]() { system.sortFlightsByPrice(flightList); });
+        }
+        for (int i = 0; i < 3; i++) {
+            timed("sortBookingsByPrice", [&]() { system.sortBookingsByPrice(); });
+        }
+        cacheStats = system.getQueryCacheStats();
+
+        // Keystroke-style input: short prefixes and single-character typos
+        for (int i = 0; i < 2000; i++) {
+            const auto& flight = schedule[flightRank[flightPick(rng)]];
+            string text = i % 3 == 2 ? flight->getFlightNumber() : flight->getArrivalCity();
+            text = text.substr(0, 1 + rng() % text.size());
+            if (i % 4 == 3 && text.size() > 2) text[1 + rng() % (text.size() - 1)] = 'x';
+            timed("autocomplete", [&]() { system.autocomplete(text, 5); });
+        }
+        autocompleteTerms = system.getAutocompleteIndex().termCount();
+        autocompleteBytes = system.getAutocompleteIndex().memoryBytes();
+    }
+
+    // One JSON object: config plus count, throughput and latency quantiles per operation
+    void writeJson(ostream& out) const {
+        out << "{\n  \"config\": {\"flights\": " << config.flights << ", \"passengers\": " << config.passengers
+            << ", \"operations\": " << config.operations << ", \"skew\": " << config.skew
+            << ", \"seed\": " << config.seed << "},\n  \"operations\": {";
+        for (size_t i = 0; i < stats.size(); i++) {
+            const LatencyHistogram& h = stats[i].second.latency;
+            double seconds = stats[i].second.seconds;
+            out << (i ? "," : "") << "\n    \"" << stats[i].first << "\": {\"count\": " << h.count()
+                << ", \"ops_per_sec\": " << (seconds > 0 ? uint64_t(h.count() / seconds) : 0)
+                << ", \"mean_ns\": " << uint64_t(h.mean()) << ", \"p50_ns\": " << h.percentile(0.50)
+                << ", \"p99_ns\": " << h.percentile(0.99) << ", \"p999_ns\": " << h.percentile(0.999)
+                << ", \"max_ns\": " << h.maxNanos() << "}";
+        }
+        out << "\n  },\n  \"query_cache\": {\"hits\": " << cacheStats.hits << ", \"misses\": " << cacheStats.misses
+            << ", \"hit_rate\": " << cacheStats.hitRate() << ", \"invalidations\": " << cacheStats.invalidations
+            << ", \"evictions\": " << cacheStats.evictions << "},\n  \"autocomplete\": {\"terms\": " << autocompleteTerms
+            << ", \"bytes\": " << autocompleteBytes << "}\n}" << endl;
+    }
+};
+
+// ============================================================================
+// MAIN FUNCTION - DEMONSTRATION
+// ============================================================================
+
+// Sample schedule used by the command-line tools below
+void addSampleSchedule(FlightBookingSystem& system) {
+    system.addFlight(FlightFactory::createFlight("Domestic", "AI101", "Delhi", "Mumbai", "10:00", "11:30", 150));
+    system.addFlight(FlightFactory::createFlight("Domestic", "AI102", "Mumbai", "Bangalore", "13:00", "14:45", 180));
+    system.addFlight(FlightFactory::createFlight("Domestic", "AI103", "Delhi", "Bangalore", "06:30", "09:15", 120));
+    system.addFlight(FlightFactory::createFlight("International", "AI301", "Delhi", "New York", "22:00", "06:00", 300));
+    system.addFlight(FlightFactory::createFlight("International", "AI302", "Mumbai", "London", "02:00", "07:30", 250));
+}
+
+// Usage: flightbooking_system simulate [overbook%] [trialsPerFlight] [showRate] [threads] [seed]
+int runOverbookingSimulation(int argc, char* argv[]) {
+    OverbookingConfig config;
+    if (argc > 2) config.overbookRate = atof(argv[2]) / 100.0;
+    if (argc > 3) config.trialsPerFlight = strtoull(argv[3], nullptr, 10);
+    if (argc > 4) config.showProbability = atof(argv[4]);
+    if (argc > 5) config.threads = static_cast<unsigned>(atoi(argv[5]));
+    if (argc > 6) config.seed = strtoull(argv[6], nullptr, 10);
+    if (!config.isValid()) {
+        cerr << "overbook% must be between 0 and 1000 and showRate between 0 and 1" << endl;
+        return 1;
+    }
+
+    FlightBookingSystem system;
+    addSampleSchedule(system);
+
+    auto start = chrono::steady_clock::now();
+    auto results = OverbookingSimulator(config).run(system.getFlights());
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Overbooking " << config.overbookRate * 100 << "%, show rate " << config.showProbability
+         << ", " << config.trialsPerFlight << " trials per flight" << endl;
+    OverbookingSimulator::printReport(results);
+    cout << "Simulated " << config.trialsPerFlight * results.size() << " trials in " << seconds << " s" << endl;
+    return 0;
+}
+
+// Usage: flightbooking_system bench [flights] [passengers] [operations] [zipfSkew] [seed]
+// Prints a JSON report on stdout.
+int runBenchmark(int argc, char* argv[]) {
+    WorkloadConfig config;
+    if (argc > 2) config.flights = strtoull(argv[2], nullptr, 10);
+    if (argc > 3) config.passengers = strtoull(argv[3], nullptr, 10);
+    if (argc > 4) config.operations = strtoull(argv[4], nullptr, 10);
+    if (argc > 5) config.skew = atof(argv[5]);
+    if (argc > 6) config.seed = strtoull(argv[6], nullptr, 10);
+    if (config.flights == 0 || config.passengers == 0) {
+        cerr << "bench needs at least one flight and one passenger" << endl;
+        return 1;
+    }
+
+    BookingBenchmark benchmark(config);
+    benchmark.run();
+    benchmark.writeJson(cout);
+    return 0;
+}
+
+// Usage: flightbooking_system service [requests] [workers] [queueCapacity]
+// Fires a burst of creates and then confirms through BookingService.
+int runServiceDemo(int argc, char* argv[]) {
+    size_t requests = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    BookingService::Config config;
+    if (argc > 3) config.workers = static_cast<unsigned>(atoi(argv[3]));
+    if (argc > 4) config.queueCapacity = strtoull(argv[4], nullptr, 10);
+
+    FlightBookingSystem system;
+    addSampleSchedule(system);
+    vector<string> flightNumbers;
+    for (const auto& f : system.getFlights()) flightNumbers.push_back(f->getFlightNumber());
+    vector<shared_ptr<Passenger>> people;
+    for (size_t i = 0; i < 1000; i++) {
+        people.push_back(make_shared<Passenger>("Traveller " + to_string(i), "S" + to_string(100000 + i),
+                                                "+91-90000" + to_string(10000 + i), "t" + to_string(i) + "@example.com"));
+    }
+
+    size_t confirmed = 0;
+    BookingService::Stats stats;
+    auto start = chrono::steady_clock::now();
+    {
+        BookingService service(system, config);
+        vector<future<shared_ptr<Booking>>> created;
+        created.reserve(requests);
+        for (size_t i = 0; i < requests; i++) {
+            created.push_back(service.submitCreate(people[i % people.size()], flightNumbers[i % flightNumbers.size()],
+                                                   SeatClass::Economy));
+        }
+        vector<future<bool>> confirms;
+        confirms.reserve(requests);
+        for (auto& f : created) {
+            auto booking = f.get();
+            if (booking) confirms.push_back(service.submitConfirm(booking));
+        }
+        for (auto& f : confirms) confirmed += f.get();
+        stats = service.getStats();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Requests: " << stats.requests << " in " << seconds << " s ("
+         << uint64_t(stats.requests / seconds) << " req/s)" << endl;
+    cout << "Batches: " << stats.batches << ", avg batch " << double(stats.requests) / max<uint64_t>(stats.batches, 1) << endl;
+    cout << "Confirms: " << stats.confirms << " (" << confirmed << " succeeded) using "
+         << stats.seatUpdates << " seat updates" << endl;
+    return 0;
+}
+
+#ifdef __linux__
+// ============================================================================
+// BOOKING SERVER: epoll event loop + compact binary protocol (Linux only)
+// ============================================================================
+
+// Frame layout, host byte order (server and clients share a machine):
+//   u32 bodyLength | u8 op | u32 requestId | payload
+// Responses echo op and requestId, then carry a u8 status and the payload.
+// Strings are a u16 length followed by the bytes. Clients may pipeline any
+// number of requests per connection; responses come back in request order.
+enum class WireOp : uint8_t { AddFlight = 1, Book = 2, Confirm = 3, Search = 4, CheapestRoute = 5 };
+enum class WireStatus : uint8_t { Ok = 0, NotFound = 1, BadRequest = 2 };
+
+constexpr size_t WIRE_HEADER_SIZE = 9;          // length + op + requestId
+constexpr uint32_t WIRE_MAX_BODY = 1 << 20;
+
+class WireWriter {
+private:
+    string& out;
+
+public:
+    explicit WireWriter(string& o) : out(o) {}
+
+    template <typename T>
+    void put(T value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+
+    void putString(string_view text) {
+        uint16_t len = static_cast<uint16_t>(min<size_t>(text.size(), 65535));
+        put(len);
+        out.append(text.data(), len);
+    }
+
+    // Starts a frame; returns its offset for endFrame to patch the length
+    size_t beginFrame(WireOp op, uint32_t requestId) {
+        size_t start = out.size();
+        put<uint32_t>(0);
+        put(static_cast<uint8_t>(op));
+        put(requestId);
+        return start;
+    }
+
+    void endFrame(size_t start) {
+        uint32_t body = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+        memcpy(&out[start], &body, sizeof(body));
+    }
+};
+
+// Bounds-checked decoder; any overrun clears ok() instead of reading past the end
+class WireReader {
+private:
+    const char* pos;
+    const char* end;
+    bool good = true;
+
+public:
+    WireReader(const char* data, size_t len) : pos(data), end(data + len) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (static_cast<size_t>(end - pos) < sizeof(T)) { good = false; return value; }
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    string_view getString() {
+        uint16_t len = get<uint16_t>();
+        if (!good || static_cast<size_t>(end - pos) < len) { good = false; return {}; }
+        string_view text(pos, len);
+        pos += len;
+        return text;
+    }
+
+    bool ok() const { return good; }
+};
+
+// "unix:/path/to.sock", "tcp:7000" or just "7000" (loopback only)
+struct Endpoint {
+    bool isUnix = false;
+    string path;
+    uint16_t port = 0;
+
+    static Endpoint parse(const string& text) {
+        Endpoint e;
+        if (text.rfind("unix:", 0) == 0) {
+            e.isUnix = true;
+            e.path = text.substr(5);
+        } else {
+            e.port = static_cast<uint16_t>(atoi(text.substr(text.rfind(':') + 1).c_str()));
+        }
+        return e;
+    }
+
+    // Returns a connected (or bound and listening) socket, or -1
+    int open(bool listening) const {
+        int fd = socket(isUnix ? AF_UNIX : AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int rc;
+        if (isUnix) {
+            sockaddr_un addr{};
+            addr.sun_family = AF_UNIX;
+            strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+            if (listening) ::unlink(path.c_str());
+            rc = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+                           : ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        } else {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            if (listening) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            rc = listening ? ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+                           : ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+        if (rc == 0 && listening) rc = ::listen(fd, 512);
+        if (rc != 0) { ::close(fd); return -1; }
+        return fd;
+    }
+
+    string describe() const { return isUnix ? "unix:" + path : "127.0.0.1:" + to_string(port); }
+};
+
+// Single-threaded server: one epoll loop owns the FlightBookingSystem, so
+// requests need no locking. Every readable event parses all complete frames
+// in the connection buffer and answers them in one write.
+class BookingServer {
+private:
+    struct Connection {
+        int fd;
+        string in;
+        size_t inPos = 0;
+        string out;
+        size_t outPos = 0;
+        bool watchingReads = true;
+        bool watchingWrites = false;
+        bool peerClosed = false; // client shut down its side; answer what it sent, then close
+    };
+
+    // Past this much unsent output a client that does not read gets no
+    // more of its requests served until it catches up
+    static constexpr size_t MAX_PENDING_OUTPUT = 4 << 20;
+
+    FlightBookingSystem& system;
+    RouteOptimizer routes;
+    int listenFd = -1;
+    int epollFd = -1;
+    unordered_map<int, unique_ptr<Connection>> connections;
+    atomic<bool> running{false};
+    uint64_t requestsServed = 0;
+
+    static void setNonBlocking(int fd) { fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK); }
+
+    static size_t pendingOutput(const Connection& c) { return c.out.size() - c.outPos; }
+
+    // Reads while the client may send more and is keeping up; writes while output is queued
+    void watch(Connection& c) {
+        bool reads = !c.peerClosed && pendingOutput(c) < MAX_PENDING_OUTPUT;
+        bool writes = pendingOutput(c) > 0;
+        if (reads == c.watchingReads && writes == c.watchingWrites) return;
+        epoll_event ev{};
+        ev.events = (reads ? static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP) : 0u) | (writes ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+        ev.data.fd = c.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.watchingReads = reads;
+        c.watchingWrites = writes;
+    }
+
+    void closeConnection(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) return;
+            setNonBlocking(fd);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+            auto conn = make_unique<Connection>();
+            conn->fd = fd;
+            connections[fd] = move(conn);
+        }
+    }
+
+    void handleFrame(WireOp op, uint32_t requestId, WireReader& req, string& out) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(op, requestId);
+        size_t statusPos = out.size();
+        w.put(static_cast<uint8_t>(WireStatus::Ok));
+        auto setStatus = [&](WireStatus st) { out[statusPos] = static_cast<char>(st); };
+
+        switch (op) {
+            case WireOp::AddFlight: {
+                string type(req.getString()), fn(req.getString()), dep(req.getString()), arr(req.getString());
+                string depTime(req.getString()), arrTime(req.getString());
+                int32_t seats = req.get<int32_t>();
+                if (!req.ok() || !Flight::isValidSeatCount(seats)) { setStatus(WireStatus::BadRequest); break; }
+                auto flight = FlightFactory::createFlight(type, fn, dep, arr, depTime, arrTime, seats);
+                if (!flight || !system.addFlight(flight)) { setStatus(WireStatus::BadRequest); break; }
+                routes.addFlightRoute(dep, arr, flight->getFare());
+                w.put<double>(flight->getFare());
+                break;
+            }
+            case WireOp::Book: {
+                uint8_t seatClass = req.get<uint8_t>();
+                string flightNumber(req.getString());
+                string_view name = req.getString(), passport = req.getString();
+                string_view contact = req.getString(), email = req.getString();
+                if (!req.ok() || seatClass > 2) { setStatus(WireStatus::BadRequest); break; }
+                auto passenger = system.registerPassenger(name, passport, contact, email);
+                auto booking = system.createBooking(passenger, flightNumber, static_cast<SeatClass>(seatClass));
+                if (!booking) { setStatus(WireStatus::NotFound); break; }
+                w.put<uint64_t>(booking->getBookingId());
+                w.put<double>(booking->getTotalPrice());
+                break;
+            }
+            case WireOp::Confirm: {
+                BookingId id = req.get<uint64_t>();
+                if (!req.ok()) { setStatus(WireStatus::BadRequest); break; }
+                if (!system.findBooking(id)) { setStatus(WireStatus::NotFound); break; }
+                w.put(static_cast<uint8_t>(system.confirmOrWaitlist(id)));
+                break;
+            }
+            case WireOp::Search: {
+                FlightQuery q;
+                q.origin = string(req.getString());
+                q.destination = string(req.getString());
+                q.departAfter = req.get<int32_t>();
+                q.departBefore = req.get<int32_t>();
+                q.minPrice = req.get<double>();
+                q.maxPrice = req.get<double>();
+                q.minFreeSeats = req.get<int32_t>();
+                uint16_t limit = req.get<uint16_t>();
+                if (!req.ok()) { setStatus(WireStatus::BadRequest); break; }
+                size_t countPos = out.size();
+                w.put<uint16_t>(0);
+                uint16_t count = 0;
+                auto cursor = system.query(q);
+                const Flight* flight;
+                while (count < limit && cursor.next(flight)) {
+                    size_t entry = out.size();
+                    w.putString(flight->getFlightNumber());
+                    w.putString(flight->getDepartureCity());
+                    w.putString(flight->getArrivalCity());
+                    w.put<int32_t>(flight->getDepartureMinutes());
+                    w.put<int32_t>(flight->getAvailableSeats());
+                    w.put<double>(flight->getFare());
+                    // Clients reject bodies over WIRE_MAX_BODY: answer with fewer results instead
+                    if (out.size() - frame - sizeof(uint32_t) > WIRE_MAX_BODY) {
+                        out.resize(entry);
+                        break;
+                    }
+                    count++;
+                }
+                memcpy(&out[countPos], &count, sizeof(count));
+                break;
+            }
+            case WireOp::CheapestRoute: {
+                string from(req.getString()), to(req.getString());
+                if (!req.ok()) { setStatus(WireStatus::BadRequest); break; }
+                w.put<double>(routes.findCheapestRoute(from, to));
+                break;
+            }
+            default:
+                setStatus(WireStatus::BadRequest);
+        }
+        w.endFrame(frame);
+        requestsServed++;
+    }
+
+    // Returns false if the connection should be closed
+    bool handleReadable(Connection& c) {
+        char buf[64 * 1024];
+        while (!c.peerClosed) {
+            ssize_t n = ::read(c.fd, buf, sizeof(buf));
+            if (n > 0) { c.in.append(buf, n); continue; }
+            if (n == 0) { c.peerClosed = true; break; } // frames already received still get answers
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return false;
+        }
+        return serve(c);
+    }
+
+    // Answers complete frames (pipelining) until the output backlog reaches
+    // MAX_PENDING_OUTPUT. Returns how many, or -1 on a malformed frame.
+    int processFrames(Connection& c) {
+        int handled = 0;
+        while (c.in.size() - c.inPos >= WIRE_HEADER_SIZE && pendingOutput(c) < MAX_PENDING_OUTPUT) {
+            uint32_t body;
+            memcpy(&body, c.in.data() + c.inPos, sizeof(body));
+            if (body < WIRE_HEADER_SIZE - sizeof(uint32_t) || body > WIRE_MAX_BODY) return -1;
+            if (c.in.size() - c.inPos < sizeof(uint32_t) + body) break;
+            WireReader header(c.in.data() + c.inPos + sizeof(uint32_t), body);
+            auto op = static_cast<WireOp>(header.get<uint8_t>());
+            uint32_t requestId = header.get<uint32_t>();
+            WireReader payload(c.in.data() + c.inPos + WIRE_HEADER_SIZE, body - (WIRE_HEADER_SIZE - sizeof(uint32_t)));
+            handleFrame(op, requestId, payload, c.out);
+            c.inPos += sizeof(uint32_t) + body;
+            handled++;
+        }
+        if (c.inPos == c.in.size()) { c.in.clear(); c.inPos = 0; }
+        else if (c.inPos > 64 * 1024) { c.in.erase(0, c.inPos); c.inPos = 0; }
+        return handled;
+    }
+
+    // Sends queued output until done or the socket would block; false on error
+    bool flush(Connection& c) {
+        while (c.outPos < c.out.size()) {
+            ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n > 0) { c.outPos += n; continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            return false;
+        }
+        c.out.clear();
+        c.outPos = 0;
+        return true;
+    }
+
+    // Alternates answering buffered frames and sending replies until the
+    // socket would block or the input is used up; returns false to close
+    bool serve(Connection& c) {
+        while (true) {
+            int handled = processFrames(c);
+            if (handled < 0 || !flush(c)) return false;
+            if (pendingOutput(c) > 0 || handled == 0) break;
+        }
+        if (c.peerClosed && pendingOutput(c) == 0) return false; // everything answered
+        watch(c);
+        return true;
+    }
+
+public:
+    explicit BookingServer(FlightBookingSystem& sys) : system(sys) {
+        for (const auto& f : system.getFlights()) {
+            routes.addFlightRoute(f->getDepartureCity(), f->getArrivalCity(), f->getFare());
+        }
+    }
+
+    ~BookingServer() {
+        for (auto& entry : connections) ::close(entry.first);
+        if (listenFd >= 0) ::close(listenFd);
+        if (epollFd >= 0) ::close(epollFd);
+    }
+
+    bool listen(const Endpoint& endpoint) {
+        listenFd = endpoint.open(true);
+        if (listenFd < 0) return false;
+        setNonBlocking(listenFd);
+        epollFd = epoll_create1(0);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+        return true;
+    }
+
+    // Serves until stop() is called (safe from a signal handler or another thread)
+    void run() {
+        running = true;
+        epoll_event events[256];
+        while (running) {
+            int n = epoll_wait(epollFd, events, 256, 200);
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) { acceptAll(); continue; }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                Connection& c = *it->second;
+                bool keep = !(events[i].events & (EPOLLERR | EPOLLHUP));
+                if (keep && (events[i].events & (EPOLLIN | EPOLLRDHUP))) keep = handleReadable(c);
+                if (keep && (events[i].events & EPOLLOUT)) keep = serve(c);
+                if (!keep) closeConnection(fd);
+            }
+        }
+    }
+
+    void stop() { running = false; }
+    uint64_t getRequestsServed() const { return requestsServed; }
+};
+
+// Blocking client with explicit pipelining: queue any number of requests,
+// flush() them in one write, then read the responses in order.
+class BookingClient {
+public:
+    struct Response {
+        WireOp op;
+        uint32_t requestId;
+        WireStatus status;
+        string payload;
+
+        WireReader reader() const { return WireReader(payload.data(), payload.size()); }
+    };
+
+private:
+    int fd = -1;
+    string out;
+    string in;
+    size_t inPos = 0;
+    uint32_t nextId = 1;
+
+public:
+    BookingClient() = default;
+    BookingClient(const BookingClient&) = delete;
+    BookingClient& operator=(const BookingClient&) = delete;
+    ~BookingClient() { if (fd >= 0) ::close(fd); }
+
+    bool connect(const Endpoint& endpoint) {
+        fd = endpoint.open(false);
+        return fd >= 0;
+    }
+
+    uint32_t queueAddFlight(const string& type, const string& fn, const string& dep, const string& arr,
+                            const string& depTime, const string& arrTime, int seats) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(WireOp::AddFlight, nextId);
+        w.putString(type); w.putString(fn); w.putString(dep); w.putString(arr);
+        w.putString(depTime); w.putString(arrTime);
+        w.put<int32_t>(seats);
+        w.endFrame(frame);
+        return nextId++;
+    }
+
+    uint32_t queueBook(const string& flightNumber, SeatClass seatClass, string_view name, string_view passport,
+                       string_view contact, string_view email) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(WireOp::Book, nextId);
+        w.put(static_cast<uint8_t>(seatClass));
+        w.putString(flightNumber);
+        w.putString(name); w.putString(passport); w.putString(contact); w.putString(email);
+        w.endFrame(frame);
+        return nextId++;
+    }
+
+    uint32_t queueConfirm(BookingId id) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(WireOp::Confirm, nextId);
+        w.put<uint64_t>(id);
+        w.endFrame(frame);
+        return nextId++;
+    }
+
+    uint32_t queueSearch(const FlightQuery& q, uint16_t limit) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(WireOp::Search, nextId);
+        w.putString(q.origin); w.putString(q.destination);
+        w.put<int32_t>(q.departAfter); w.put<int32_t>(q.departBefore);
+        w.put<double>(q.minPrice); w.put<double>(q.maxPrice);
+        w.put<int32_t>(q.minFreeSeats);
+        w.put<uint16_t>(limit);
+        w.endFrame(frame);
+        return nextId++;
+    }
+
+    uint32_t queueCheapestRoute(const string& from, const string& to) {
+        WireWriter w(out);
+        size_t frame = w.beginFrame(WireOp::CheapestRoute, nextId);
+        w.putString(from); w.putString(to);
+        w.endFrame(frame);
+        return nextId++;
+    }
+
+    bool flush() {
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = ::send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += n;
+        }
+        out.clear();
+        return true;
+    }
+
+    bool readResponse(Response& r) {
+        while (true) {
+            if (in.size() - inPos >= sizeof(uint32_t)) {
+                uint32_t body;
+                memcpy(&body, in.data() + inPos, sizeof(body));
+                // Same bounds the server applies, plus room for the status byte
+                if (body < WIRE_HEADER_SIZE + 1 - sizeof(uint32_t) || body > WIRE_MAX_BODY) return false;
+                if (in.size() - inPos >= sizeof(uint32_t) + body) {
+                    WireReader header(in.data() + inPos + sizeof(uint32_t), body);
+                    r.op = static_cast<WireOp>(header.get<uint8_t>());
+                    r.requestId = header.get<uint32_t>();
+                    r.status = static_cast<WireStatus>(header.get<uint8_t>());
+                    size_t headerLen = WIRE_HEADER_SIZE + 1;
+                    r.payload.assign(in.data() + inPos + headerLen, sizeof(uint32_t) + body - headerLen);
+                    inPos += sizeof(uint32_t) + body;
+                    if (inPos == in.size()) { in.clear(); inPos = 0; }
+                    return header.ok();
+                }
+            }
+            char buf[64 * 1024];
+            ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            in.append(buf, n);
+        }
+    }
+
+    // Synchronous helper: flush whatever is queued and wait for the last response
+    bool call(Response& r) {
+        uint32_t last = nextId - 1;
+        if (!flush()) return false;
+        do {
+            if (!readResponse(r)) return false;
+        } while (r.requestId != last);
+        return true;
+    }
+};
+
+// SIGINT / SIGTERM make server.run() return
+void stopOnSignal(BookingServer& server) {
+    static BookingServer* active = nullptr;
+    active = &server;
+    signal(SIGINT, [](int) { if (active) active->stop(); });
+    signal(SIGTERM, [](int) { if (active) active->stop(); });
+}
+
+// ============================================================================
+// SHARDED DEPLOYMENT: one server process per shard + client-side router
+// ============================================================================
+
+// Forks one BookingServer per shard on a private Unix socket. Shard i runs a
+// FlightBookingSystem with shard ID i, so every booking ID names its shard.
+class ShardCluster {
+private:
+    vector<pid_t> children;
+    vector<Endpoint> endpoints;
+
+public:
+    ShardCluster() = default;
+    ShardCluster(const ShardCluster&) = delete;
+    ShardCluster& operator=(const ShardCluster&) = delete;
+    ~ShardCluster() { stop(); }
+
+    bool start(unsigned shards) {
+        cout.flush();
+        for (unsigned i = 0; i < shards; i++) {
+            Endpoint e = Endpoint::parse("unix:/tmp/fbs-" + to_string(getpid()) + "-shard" + to_string(i) + ".sock");
+            pid_t pid = fork();
+            if (pid < 0) return false;
+            if (pid == 0) {
+                FlightBookingSystem system(static_cast<uint16_t>(i));
+                BookingServer server(system);
+                if (!server.listen(e)) _exit(1);
+                stopOnSignal(server);
+                server.run();
+                ::unlink(e.path.c_str());
+                _exit(0);
+            }
+            children.push_back(pid);
+            endpoints.push_back(e);
+        }
+        return true;
+    }
+
+    void stop() {
+        for (pid_t pid : children) kill(pid, SIGTERM);
+        for (pid_t pid : children) waitpid(pid, nullptr, 0);
+        children.clear();
+    }
+
+    const vector<Endpoint>& getEndpoints() const { return endpoints; }
+};
+
+// Client-side router with the FlightBookingSystem call surface. Bookings go
+// to the shard owning the flight, confirms to the shard encoded in the
+// booking ID, searches fan out (pipelined to all shards at once) and the
+// partial results are merged by departure time. Routes span shards, so the
+// route graph is kept by the router itself. One router per thread.
+class ShardRouter {
+public:
+    enum class Partitioning { FlightNumber, Route };
+
+    struct FlightSummary {
+        string flightNumber, origin, destination;
+        TimeMinutes departure;
+        int availableSeats;
+        double price;
+    };
+
+private:
+    vector<unique_ptr<BookingClient>> shards;
+    Partitioning partitioning;
+    unordered_map<string, uint32_t> flightShard; // learned from addFlight / discover
+    RouteOptimizer routes;
+
+    uint32_t shardForRoute(const string& origin, const string& destination) const {
+        return static_cast<uint32_t>(hashString(origin + "\n" + destination) % shards.size());
+    }
+
+    static bool readFlights(const BookingClient::Response& r, vector<FlightSummary>& out) {
+        WireReader rd = r.reader();
+        uint16_t n = rd.get<uint16_t>();
+        for (uint16_t i = 0; i < n && rd.ok(); i++) {
+            FlightSummary f;
+            f.flightNumber = string(rd.getString());
+            f.origin = string(rd.getString());
+            f.destination = string(rd.getString());
+            f.departure = rd.get<int32_t>();
+            f.availableSeats = rd.get<int32_t>();
+            f.price = rd.get<double>();
+            out.push_back(move(f));
+        }
+        return rd.ok();
+    }
+
+public:
+    explicit ShardRouter(Partitioning p = Partitioning::Route) : partitioning(p) {}
+
+    // Connects to every shard, retrying briefly while freshly forked shards start
+    bool connect(const vector<Endpoint>& endpoints) {
+        for (const auto& e : endpoints) {
+            auto client = make_unique<BookingClient>();
+            bool connected = false;
+            for (int attempt = 0; attempt < 200 && !connected; attempt++) {
+                connected = client->connect(e);
+                if (!connected) this_thread::sleep_for(chrono::milliseconds(10));
+            }
+            if (!connected) return false;
+            shards.push_back(move(client));
+        }
+        return !shards.empty();
+    }
+
+    size_t shardCount() const { return shards.size(); }
+
+    uint32_t shardForFlight(const string& flightNumber, const string& origin, const string& destination) const {
+        if (partitioning == Partitioning::Route) return shardForRoute(origin, destination);
+        return static_cast<uint32_t>(hashString(flightNumber) % shards.size());
+    }
+
+    bool addFlight(const string& type, const string& fn, const string& dep, const string& arr,
+                   const string& depTime, const string& arrTime, int seats) {
+        uint32_t shard = shardForFlight(fn, dep, arr);
+        BookingClient::Response r;
+        shards[shard]->queueAddFlight(type, fn, dep, arr, depTime, arrTime, seats);
+        if (!shards[shard]->call(r) || r.status != WireStatus::Ok) return false;
+        flightShard[fn] = shard;
+        routes.addFlightRoute(dep, arr, r.reader().get<double>());
+        return true;
+    }
+
+    // Learns flight placement and routes from the shards (for routers created
+    // after the schedule was loaded)
+    bool discover() {
+        for (auto& shard : shards) shard->queueSearch(FlightQuery(), 65535);
+        for (uint32_t i = 0; i < shards.size(); i++) {
+            BookingClient::Response r;
+            vector<FlightSummary> found;
+            if (!shards[i]->call(r) || !readFlights(r, found)) return false;
+            for (const auto& f : found) {
+                flightShard[f.flightNumber] = i;
+                routes.addFlightRoute(f.origin, f.destination, f.price);
+            }
+        }
+        return true;
+    }
+
+    // Returns the new booking ID, or 0 if the flight is unknown
+    BookingId book(const string& flightNumber, SeatClass seatClass, string_view name, string_view passport,
+                   string_view contact, string_view email) {
+        auto it = flightShard.find(flightNumber);
+        if (it == flightShard.end()) return 0;
+        BookingClient::Response r;
+        shards[it->second]->queueBook(flightNumber, seatClass, name, passport, contact, email);
+        if (!shards[it->second]->call(r) || r.status != WireStatus::Ok) return 0;
+        return r.reader().get<uint64_t>();
+    }
+
+    BookingStatus confirm(BookingId id) {
+        uint16_t shard = BookingIdGenerator::shardOf(id);
+        BookingClient::Response r;
+        if (shard >= shards.size()) return BookingStatus::Cancelled;
+        shards[shard]->queueConfirm(id);
+        if (!shards[shard]->call(r) || r.status != WireStatus::Ok) return BookingStatus::Cancelled;
+        return static_cast<BookingStatus>(r.reader().get<uint8_t>());
+    }
+
+    // Single shard when route partitioning pins the query, otherwise fan-out + merge
+    vector<FlightSummary> search(const FlightQuery& q, uint16_t limit) {
+        vector<uint32_t> targets;
+        if (partitioning == Partitioning::Route && !q.origin.empty() && !q.destination.empty()) {
+            targets.push_back(shardForRoute(q.origin, q.destination));
+        } else {
+            for (uint32_t i = 0; i < shards.size(); i++) targets.push_back(i);
+        }
+        for (uint32_t t : targets) {
+            shards[t]->queueSearch(q, limit);
+            shards[t]->flush();
+        }
+        vector<FlightSummary> merged;
+        for (uint32_t t : targets) {
+            BookingClient::Response r;
+            if (shards[t]->readResponse(r) && r.status == WireStatus::Ok) readFlights(r, merged);
+        }
+        stable_sort(merged.begin(), merged.end(), [](const FlightSummary& a, const FlightSummary& b) {
+            return a.departure < b.departure;
+        });
+        if (merged.size() > limit) merged.resize(limit);
+        return merged;
+    }
+
+    double findCheapestRoute(const string& from, const string& to) { return routes.findCheapestRoute(from, to); }
+};
+
+// Usage: flightbooking_system shardbench [maxShards] [clients] [requestsPerClient] [flights]
+// Runs the same booking/search mix against 1..maxShards shard processes.
+int runShardBenchmark(int argc, char* argv[]) {
+    unsigned maxShards = argc > 2 ? atoi(argv[2]) : 4;
+    unsigned clients = argc > 3 ? atoi(argv[3]) : 8;
+    size_t requests = argc > 4 ? strtoull(argv[4], nullptr, 10) : 5000;
+    WorkloadConfig config;
+    config.flights = argc > 5 ? strtoull(argv[5], nullptr, 10) : 2000;
+    WorkloadGenerator generator(config);
+    auto schedule = generator.makeSchedule();
+
+    cout << "{\"flights\": " << schedule.size() << ", \"clients\": " << clients
+         << ", \"requests_per_client\": " << requests << ", \"runs\": [";
+    for (unsigned n = 1; n <= maxShards; n++) {
+        ShardCluster cluster;
+        if (!cluster.start(n)) { perror("fork"); return 1; }
+        {
+            ShardRouter loader;
+            if (!loader.connect(cluster.getEndpoints())) { cerr << "cannot reach shards" << endl; return 1; }
+            for (const auto& f : schedule) {
+                loader.addFlight(f->getFlightType(), f->getFlightNumber(), f->getDepartureCity(), f->getArrivalCity(),
+                                 f->getDepartureTime(), f->getArrivalTime(), f->getTotalSeats());
+            }
+        }
+
+        vector<LatencyHistogram> latency(clients);
+        auto start = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (unsigned c = 0; c < clients; c++) {
+            threads.emplace_back([&, c]() {
+                ShardRouter router;
+                if (!router.connect(cluster.getEndpoints()) || !router.discover()) return;
+                mt19937_64 rng(500 + c);
+                for (size_t i = 0; i < requests; i++) {
+                    const auto& f = schedule[rng() % schedule.size()];
+                    auto t0 = chrono::steady_clock::now();
+                    int roll = static_cast<int>(rng() % 100);
+                    if (roll < 50) {
+                        string passport = "R" + to_string(c) + "-" + to_string(i);
+                        BookingId id = router.book(f->getFlightNumber(), SeatClass::Economy, "Shard Tester", passport,
+                                                   "+91-9000000000", "shard@example.com");
+                        if (id) router.confirm(id);
+                    } else {
+                        FlightQuery q;
+                        q.origin = f->getDepartureCity();
+                        if (roll < 80) q.destination = f->getArrivalCity();
+                        q.minFreeSeats = 1;
+                        router.search(q, 20);
+                    }
+                    latency[c].record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cluster.stop();
+
+        LatencyHistogram all;
+        for (const auto& h : latency) all.merge(h);
+        cout << (n > 1 ? "," : "") << "\n  {\"shards\": " << n << ", \"ops_per_sec\": " << uint64_t(all.count() / seconds)
+             << ", \"p50_ns\": " << all.percentile(0.5) << ", \"p99_ns\": " << all.percentile(0.99) << "}";
+        cout.flush();
+    }
+    cout << "\n]}" << endl;
+    return 0;
+}
+
+// Usage: flightbooking_system shmdemo [workers] [bookingsPerWorker]
+// Forks worker processes that each load their own copy of the schedule but
+// share seat counts and seat bitmaps through one shared-memory segment.
+// A worker exits 0 when done, 2 if it cannot map the segment and 1 if a
+// confirmed booking found no free seat number.
+int runSharedInventoryDemo(int argc, char* argv[]) {
+    int workers = argc > 2 ? atoi(argv[2]) : 4;
+    int perWorker = argc > 3 ? atoi(argv[3]) : 200;
+    string segment = "/fbs-inventory-" + to_string(getpid());
+
+    auto inventory = SharedSeatInventory::create(segment, 64);
+    if (!inventory) { perror("shm_open"); return 1; }
+    {
+        FlightBookingSystem loader;
+        addSampleSchedule(loader);
+        loader.attachSharedInventory(*inventory);
+    }
+
+    cout.flush();
+    vector<pid_t> children;
+    for (int w = 0; w < workers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            auto mapped = SharedSeatInventory::open(segment);
+            if (!mapped) _exit(2);
+            FlightBookingSystem system(static_cast<uint16_t>(w + 1));
+            addSampleSchedule(system);
+            system.attachSharedInventory(*mapped);
+            mt19937_64 rng(w);
+            const auto& flights = system.getFlights();
+            bool seated = true;
+            for (int i = 0; i < perWorker; i++) {
+                auto passenger = system.registerPassenger("Worker " + to_string(w), "W" + to_string(w) + "-" + to_string(i),
+                                                          "+91-9000000000", "worker@example.com");
+                const auto& flight = flights[rng() % flights.size()];
+                auto booking = system.createBooking(passenger, flight->getFlightNumber(), SeatClass::Economy);
+                if (booking && booking->confirmBooking() && flight->getSharedSeats()->claimFreeSeat() < 0) {
+                    seated = false;
+                }
+            }
+            _exit(seated ? 0 : 1);
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        children.push_back(pid);
+    }
+    int failedWorkers = workers - static_cast<int>(children.size());
+    for (pid_t pid : children) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) failedWorkers++;
+    }
+
+    auto view = SharedSeatInventory::open(segment);
+    if (!view) {
+        perror("shm_open");
+        SharedSeatInventory::unlinkSegment(segment);
+        return 1;
+    }
+    FlightBookingSystem reader;
+    addSampleSchedule(reader);
+    reader.attachSharedInventory(*view);
+    int sold = 0, assigned = 0;
+    for (const auto& flight : reader.getFlights()) {
+        SharedFlightSlot* slot = flight->getSharedSeats();
+        int taken = flight->getTotalSeats() - flight->getAvailableSeats();
+        cout << flight->getFlightNumber() << ": " << taken << "/" << flight->getTotalSeats()
+             << " sold, " << slot->assignedSeats() << " seats assigned" << endl;
+        sold += taken;
+        assigned += slot->assignedSeats();
+    }
+    cout << workers << " workers (" << failedWorkers << " failed), " << sold << " seats sold, " << assigned
+         << " assigned, counts " << (sold == assigned ? "agree" : "DISAGREE") << endl;
+    SharedSeatInventory::unlinkSegment(segment);
+    return sold == assigned && failedWorkers == 0 ? 0 : 1;
+}
+
+// Usage: flightbooking_system server <endpoint> [syntheticFlights]
+// Endpoint is "unix:/path" or a loopback TCP port. Stop with Ctrl-C.
+int runServer(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: server <unix:/path | port> [syntheticFlights]" << endl;
+        return 1;
+    }
+    Endpoint endpoint = Endpoint::parse(argv[2]);
+    size_t synthetic = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+
+    FlightBookingSystem system;
+    if (synthetic > 0) {
+        WorkloadConfig config;
+        config.flights = synthetic;
+        WorkloadGenerator generator(config);
+        for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    } else {
+        addSampleSchedule(system);
+    }
+
+    BookingServer server(system);
+    if (!server.listen(endpoint)) {
+        perror("listen");
+        return 1;
+    }
+    stopOnSignal(server);
+
+    cerr << "Serving " << system.getFlights().size() << " flights on " << endpoint.describe() << endl;
+    server.run();
+    cerr << "Served " << server.getRequestsServed() << " requests" << endl;
+    if (endpoint.isUnix) ::unlink(endpoint.path.c_str());
+    return 0;
+}
+
+// Usage: flightbooking_system loadclient <endpoint> [connections] [requestsPerConnection] [pipelineDepth]
+// Keeps pipelineDepth requests in flight per connection (book, confirm,
+// search and route queries) and prints throughput and latency as JSON.
+int runLoadClient(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "usage: loadclient <unix:/path | port> [connections] [requests] [depth]" << endl;
+        return 1;
+    }
+    Endpoint endpoint = Endpoint::parse(argv[2]);
+    unsigned connections = argc > 3 ? atoi(argv[3]) : 4;
+    size_t requests = argc > 4 ? strtoull(argv[4], nullptr, 10) : 50000;
+    size_t depth = argc > 5 ? strtoull(argv[5], nullptr, 10) : 32;
+    depth = max<size_t>(depth, 1);
+
+    // Discover the schedule once so bookings target real flights
+    vector<tuple<string, string, string>> schedule; // flight, origin, destination
+    {
+        BookingClient probe;
+        BookingClient::Response r;
+        if (!probe.connect(endpoint)) { perror("connect"); return 1; }
+        probe.queueSearch(FlightQuery(), 65535);
+        if (!probe.call(r)) { cerr << "no response from server" << endl; return 1; }
+        WireReader rd = r.reader();
+        uint16_t n = rd.get<uint16_t>();
+        for (uint16_t i = 0; i < n; i++) {
+            string fn(rd.getString()), from(rd.getString()), to(rd.getString());
+            rd.get<int32_t>();
+            rd.get<int32_t>();
+            rd.get<double>();
+            schedule.emplace_back(fn, from, to);
+        }
+        if (schedule.empty()) { cerr << "server has no flights" << endl; return 1; }
+    }
+
+    const char* opNames[] = {"", "addFlight", "book", "confirm", "search", "cheapestRoute"};
+    vector<array<LatencyHistogram, 6>> perThread(connections);
+    vector<uint64_t> failures(connections, 0);
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (unsigned t = 0; t < connections; t++) {
+        threads.emplace_back([&, t]() {
+            BookingClient client;
+            if (!client.connect(endpoint)) { failures[t] = requests; return; }
+            mt19937_64 rng(1000 + t);
+            unordered_map<uint32_t, chrono::steady_clock::time_point> sentAt;
+            vector<BookingId> toConfirm;
+            size_t sent = 0, received = 0;
+            BookingClient::Response r;
+            while (received < requests) {
+                while (sent < requests && sent - received < depth) {
+                    const auto& [fn, from, to] = schedule[rng() % schedule.size()];
+                    uint32_t id;
+                    int roll = static_cast<int>(rng() % 100);
+                    if (!toConfirm.empty()) {
+                        id = client.queueConfirm(toConfirm.back());
+                        toConfirm.pop_back();
+                    } else if (roll < 40) {
+                        string passport = "L" + to_string(t) + "-" + to_string(rng() % 100000);
+                        id = client.queueBook(fn, SeatClass::Economy, "Load Tester", passport, "+91-9000000000", "load@example.com");
+                    } else if (roll < 85) {
+                        FlightQuery q;
+                        q.origin = from;
+                        q.minFreeSeats = 1;
+                        id = client.queueSearch(q, 20);
+                    } else {
+                        id = client.queueCheapestRoute(from, get<2>(schedule[rng() % schedule.size()]));
+                    }
+                    sentAt[id] = chrono::steady_clock::now();
+                    sent++;
+                }
+                if (!client.flush() || !client.readResponse(r)) { failures[t] += requests - received; return; }
+                auto now = chrono::steady_clock::now();
+                auto it = sentAt.find(r.requestId);
+                if (it != sentAt.end()) {
+                    perThread[t][static_cast<size_t>(r.op) % 6].record(
+                        chrono::duration_cast<chrono::nanoseconds>(now - it->second).count());
+                    sentAt.erase(it);
+                }
+                if (r.status != WireStatus::Ok) failures[t]++;
+                if (r.op == WireOp::Book && r.status == WireStatus::Ok) {
+                    toConfirm.push_back(r.reader().get<uint64_t>());
+                }
+                received++;
+            }
+        });
+    }
+    for (auto& th : threads) th.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    array<LatencyHistogram, 6> total;
+    uint64_t failed = 0;
+    for (unsigned t = 0; t < connections; t++) {
+        for (size_t op = 0; op < 6; op++) total[op].merge(perThread[t][op]);
+        failed += failures[t];
+    }
+    LatencyHistogram all;
+    for (const auto& h : total) all.merge(h);
+    cout << "{\n  \"endpoint\": \"" << endpoint.describe() << "\", \"connections\": " << connections
+         << ", \"depth\": " << depth << ", \"requests\": " << all.count() << ", \"failed\": " << failed
+         << ", \"seconds\": " << seconds << ", \"requests_per_sec\": " << uint64_t(all.count() / seconds)
+         << ",\n  \"latency\": {";
+    bool firstOp = true;
+    for (size_t op = 1; op < 6; op++) {
+        if (total[op].count() == 0) continue;
+        cout << (firstOp ? "" : ",") << "\n    \"" << opNames[op] << "\": {\"count\": " << total[op].count()
+             << ", \"p50_ns\": " << total[op].percentile(0.5) << ", \"p99_ns\": " << total[op].percentile(0.99)
+             << ", \"p999_ns\": " << total[op].percentile(0.999) << "}";
+        firstOp = false;
+    }
+    cout << "\n  }\n}" << endl;
+    return 0;
+}
+#endif
+
+// Usage: flightbooking_system snapbench [readers] [seconds] [flights]
+// Measures lock-free snapshot reads alone and while a writer books and
+// cancels seats as fast as it can.
+int runSnapshotBenchmark(int argc, char* argv[]) {
+    unsigned readers = argc > 2 ? atoi(argv[2]) : max(1u, thread::hardware_concurrency() - 1);
+    double seconds = argc > 3 ? atof(argv[3]) : 1.0;
+    WorkloadConfig config;
+    config.flights = argc > 4 ? strtoull(argv[4], nullptr, 10) : 2000;
+
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+
+    auto measure = [&](bool withWriter) {
+        atomic<bool> stop{false};
+        atomic<uint64_t> reads{0}, writes{0}, inconsistent{0};
+        vector<thread> threads;
+        for (unsigned r = 0; r < readers; r++) {
+            threads.emplace_back([&]() {
+                uint64_t local = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    auto found = system.findFlightsByPriceRange(0, 10000);
+                    // Every snapshot must be internally consistent
+                    system.getInventory().read([&](const InventorySnapshots::Version& v) {
+                        for (size_t i = 0; i < v.size(); i++) {
+                            if (v[i].availableSeats < 0 || v[i].availableSeats > v[i].totalSeats) inconsistent++;
+                        }
+                    });
+                    local += 2;
+                    (void)found;
+                }
+                reads += local;
+            });
+        }
+        if (withWriter) {
+            threads.emplace_back([&]() {
+                mt19937_64 rng(99);
+                const auto& flights = system.getFlights();
+                uint64_t local = 0;
+                while (!stop.load(memory_order_relaxed)) {
+                    auto booking = system.createBooking(people[rng() % people.size()],
+                                                        flights[rng() % flights.size()]->getFlightNumber(),
+                                                        SeatClass::Economy);
+                    system.confirmOrWaitlist(booking->getBookingId());
+                    if (rng() % 2) system.cancelBooking(booking->getBookingId());
+                    local++;
+                }
+                writes += local;
+            });
+        }
+        this_thread::sleep_for(chrono::duration<double>(seconds));
+        stop = true;
+        for (auto& t : threads) t.join();
+        cout << (withWriter ? "with writer:    " : "reads only:     ") << uint64_t(reads / seconds) << " reads/s";
+        if (withWriter) cout << ", " << uint64_t(writes / seconds) << " bookings/s";
+        cout << ", inconsistent snapshots: " << inconsistent << endl;
+    };
+
+    cout << readers << " reader thread(s), " << config.flights << " flights, " << seconds << " s per run" << endl;
+    measure(false);
+    measure(true);
+    cout << "inventory version: " << system.getInventory().versionNumber() << endl;
+    return 0;
+}
+
+// Usage: flightbooking_system sortbench [flights] [repeats]
+// Times sortFlightsByPrice against std::sort on random, duplicate-heavy,
+// presorted and all-equal price distributions.
+int runSortBenchmark(int argc, char* argv[]) {
+    size_t n = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    int repeats = argc > 3 ? atoi(argv[3]) : 5;
 
-        int left = 0, right = sortedFlights.size() - 1;
-        shared_ptr<Flight> result = nullptr;
+    // Arbitrary fares, so the price distribution can be controlled
+    class FixedFareFlight : public Flight {
+        double fare;
+    public:
+        FixedFareFlight(const string& fn, double fare) : Flight(fn, "A", "B", "10:00", "12:00", 100), fare(fare) {}
+        double getBasePrice() const override { return fare; }
+        string getFlightType() const override { return "Benchmark"; }
+    };
 
-        while (left <= right) {
-            int mid = left + (right - left) / 2;
-            double price = sortedFlights[mid]->getBasePrice();
+    FlightBookingSystem system;
+    mt19937_64 rng(7);
+    auto makeFlights = [&](auto priceOf) {
+        vector<shared_ptr<Flight>> list;
+        list.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            list.push_back(make_shared<FixedFareFlight>("S" + to_string(i), priceOf(i)));
+        }
+        return list;
+    };
+    vector<pair<string, vector<shared_ptr<Flight>>>> inputs;
+    inputs.emplace_back("random", makeFlights([&](size_t) { return double(rng() % 1000000); }));
+    inputs.emplace_back("few_distinct", makeFlights([&](size_t) { return 5000.0 + 5000.0 * (rng() % 4); }));
+    inputs.emplace_back("sorted", makeFlights([&](size_t i) { return double(i); }));
+    inputs.emplace_back("all_equal", makeFlights([&](size_t) { return 5000.0; }));
 
-            if (price <= maxPrice) {
-                result = sortedFlights[mid];
-                left = mid + 1; // Look for cheaper options
-            } else {
-                right = mid - 1;
+    auto bestOf = [&](const vector<shared_ptr<Flight>>& input, auto sortFn) {
+        double best = numeric_limits<double>::max();
+        for (int r = 0; r < repeats; r++) {
+            vector<shared_ptr<Flight>> work = input;
+            auto start = chrono::steady_clock::now();
+            sortFn(work);
+            best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            if (!is_sorted(work.begin(), work.end(), [](const shared_ptr<Flight>& a, const shared_ptr<Flight>& b) {
+                    return a->getFare() < b->getFare();
+                })) {
+                cerr << "sort produced unsorted output" << endl;
+                exit(1);
             }
         }
-        return result;
+        return best;
+    };
+
+    cout << "{\"flights\": " << n << ", \"repeats\": " << repeats << ", \"runs\": [" << endl;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        double intro = bestOf(inputs[i].second, [&](vector<shared_ptr<Flight>>& v) { system.sortFlightsByPrice(v); });
+        double reference = bestOf(inputs[i].second, [](vector<shared_ptr<Flight>>& v) {
+            sort(v.begin(), v.end(), [](const shared_ptr<Flight>& a, const shared_ptr<Flight>& b) {
+                return a->getFare() < b->getFare();
+            });
+        });
+        cout << "  {\"input\": \"" << inputs[i].first << "\", \"sortFlightsByPrice_ms\": " << intro
+             << ", \"std_sort_ms\": " << reference << "}" << (i + 1 < inputs.size() ? "," : "") << endl;
     }
+    cout << "]}" << endl;
+    return 0;
+}
 
-    // ============================================================================
-    // SORTING ALGORITHMS
-    // ============================================================================
+// Usage: flightbooking_system export [bookings] [maxThreads] [path]
+// Times a sequential displayBooking-style export against ManifestExporter
+// with 1, 2, 4, ... threads; output goes to path (default /dev/null).
+int runExportBenchmark(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200000;
+    unsigned maxThreads = argc > 3 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    const char* path = argc > 4 ? argv[4] : "/dev/null";
 
-    // Sort flights by price using quick sort
-    void sortFlightsByPrice(vector<shared_ptr<Flight>>& flightList) {
-        quickSort(flightList, 0, flightList.size() - 1);
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+    mt19937_64& rng = generator.random();
+    const auto& flights = system.getFlights();
+    for (size_t i = 0; i < count; i++) {
+        auto booking = system.createBooking(people[rng() % people.size()],
+                                            flights[rng() % flights.size()]->getFlightNumber(),
+                                            static_cast<SeatClass>(rng() % 3));
+        if (booking && rng() % 4) system.confirmOrWaitlist(booking->getBookingId());
     }
+    const auto& bookings = system.getBookings();
 
-    void quickSort(vector<shared_ptr<Flight>>& arr, int low, int high) {
-        if (low < high) {
-            int pi = partition(arr, low, high);
-            quickSort(arr, low, pi - 1);
-            quickSort(arr, pi + 1, high);
+    auto seconds = [](auto start) { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+    cout << "{\"bookings\": " << bookings.size() << ", \"path\": \"" << path << "\", \"runs\": [" << endl;
+    {
+        ofstream file(path, ios::binary);
+        auto start = chrono::steady_clock::now();
+        for (const auto& booking : bookings) {
+            booking->printBooking(file);
+            file << "------------------------\n";
+        }
+        file.flush();
+        cout << "  {\"mode\": \"sequential\", \"seconds\": " << seconds(start) << "}";
+    }
+    for (unsigned t = 1; t <= maxThreads; t *= 2) {
+        ManifestExporter exporter(t);
+#ifdef __linux__
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror("open");
+            return 1;
         }
+        auto start = chrono::steady_clock::now();
+        ssize_t bytes = exporter.write(fd, bookings);
+        double elapsed = seconds(start);
+        ::close(fd);
+#else
+        ofstream file(path, ios::binary);
+        auto start = chrono::steady_clock::now();
+        size_t bytes = exporter.write(file, bookings);
+        file.flush();
+        double elapsed = seconds(start);
+#endif
+        cout << ",\n  {\"mode\": \"parallel\", \"threads\": " << t << ", \"seconds\": " << elapsed
+             << ", \"bytes\": " << bytes << "}";
     }
+    cout << "\n]}" << endl;
+    return 0;
+}
 
-    int partition(vector<shared_ptr<Flight>>& arr, int low, int high) {
-        double pivot = arr[high]->getBasePrice();
-        int i = low - 1;
+// Usage: flightbooking_system archive [bookings] [path]
+// Seals bookings of flights departed by the middle of the schedule and
+// checks that live + archived revenue still adds up.
+int runArchiveDemo(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 200000;
+    string path = argc > 3 ? argv[3] : "/tmp/fbs_archive.bin";
+    remove(path.c_str());
 
-        for (int j = low; j < high; j++) {
-            if (arr[j]->getBasePrice() <= pivot) {
-                i++;
-                swap(arr[i], arr[j]);
-            }
-        }
-        swap(arr[i + 1], arr[high]);
-        return i + 1;
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+    mt19937_64& rng = generator.random();
+    const auto& flights = system.getFlights();
+    for (size_t i = 0; i < count; i++) {
+        auto booking = system.createBooking(people[rng() % people.size()],
+                                            flights[rng() % flights.size()]->getFlightNumber(),
+                                            static_cast<SeatClass>(rng() % 3));
+        if (booking) system.confirmOrWaitlist(booking->getBookingId());
     }
+    double revenueBefore = system.getTotalRevenue();
+    size_t liveBefore = system.getBookings().size();
 
-    // Sort bookings by total price using merge sort
-    void sortBookingsByPrice() {
-        mergeSort(bookings, 0, bookings.size() - 1);
+    BookingArchive archive(path);
+    // Two sealing runs, as a nightly job would do: one segment each
+    auto start = chrono::steady_clock::now();
+    size_t sealed = system.archiveDepartedBookings(archive, config.days / 4 * MINUTES_PER_DAY);
+    sealed += system.archiveDepartedBookings(archive, config.days / 2 * MINUTES_PER_DAY);
+    double sealSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    double archived;
+    bool archiveOk = archive.totalRevenue(archived);
+    double totalScan = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    map<pair<string, string>, double> byRoute;
+    archiveOk = archive.revenueByRoute(byRoute) && archiveOk;
+    double routeScan = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!archiveOk) {
+        cerr << "corrupt archive " << path << endl;
+        return 1;
     }
 
-    void mergeSort(vector<shared_ptr<Booking>>& arr, int left, int right) {
-        if (left < right) {
-            int mid = left + (right - left) / 2;
-            mergeSort(arr, left, mid);
-            mergeSort(arr, mid + 1, right);
-            merge(arr, left, mid, right);
-        }
+    size_t fileBytes = archive.fileBytes();
+    cout << "live bookings: " << liveBefore << " -> " << system.getBookings().size() << ", sealed " << sealed
+         << " in " << sealSeconds * 1000 << " ms" << endl;
+    cout << "archive: " << fileBytes << " bytes (" << (sealed ? double(fileBytes) / sealed : 0.0) << " bytes/booking)"
+         << endl;
+    cout << fixed << setprecision(2);
+    cout << "revenue before: " << revenueBefore << ", live + archived: " << system.getTotalRevenue() + archived
+         << endl;
+    cout << "archive scans: total " << totalScan * 1000 << " ms, by route (" << byRoute.size() << " routes) "
+         << routeScan * 1000 << " ms" << endl;
+    return fabs(revenueBefore - system.getTotalRevenue() - archived) <= 0.01 + revenueBefore * 1e-9 ? 0 : 1;
+}
+
+// Usage: flightbooking_system analytics [bookings] [threads]
+// Revenue by route and class, and load factor by departure hour, through the
+// columnar engine and through the equivalent loop over shared_ptr<Booking>.
+int runAnalyticsDemo(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 500000;
+    unsigned threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+    mt19937_64& rng = generator.random();
+    const auto& flights = system.getFlights();
+    for (size_t i = 0; i < count; i++) {
+        auto booking = system.createBooking(people[rng() % people.size()],
+                                            flights[rng() % flights.size()]->getFlightNumber(),
+                                            static_cast<SeatClass>(rng() % 3));
+        if (booking && rng() % 4) system.confirmOrWaitlist(booking->getBookingId());
     }
+    auto millis = [](auto start) { return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count(); };
 
-    void merge(vector<shared_ptr<Booking>>& arr, int left, int mid, int right) {
-        int n1 = mid - left + 1;
-        int n2 = right - mid;
+    auto start = chrono::steady_clock::now();
+    ColumnarProjection p = ColumnarProjection::build(system.getFlights(), system.getBookings());
+    double buildMs = millis(start);
 
-        vector<shared_ptr<Booking>> L(n1), R(n2);
-        for (int i = 0; i < n1; i++) L[i] = arr[left + i];
-        for (int j = 0; j < n2; j++) R[j] = arr[mid + 1 + j];
+    AnalyticsEngine engine(threads);
+    start = chrono::steady_clock::now();
+    auto confirmed = engine.filter(p.bookingStatus, [](uint8_t s) { return s == uint8_t(BookingStatus::Confirmed); });
+    auto routeClass = engine.combineKeys(p.bookingRoute, p.bookingClass, 3);
+    auto revenue = engine.groupBy(routeClass, p.routes.size() * 3, &p.bookingPrice, &confirmed);
+    auto sold = engine.groupBy(p.flightDepartureHour, 24, &p.flightSeatsSold);
+    auto seats = engine.groupBy(p.flightDepartureHour, 24, &p.flightTotalSeats);
+    double avgFare = engine.avg(p.bookingPrice, &confirmed);
+    double engineMs = millis(start);
 
-        int i = 0, j = 0, k = left;
-        while (i < n1 && j < n2) {
-            if (L[i]->getTotalPrice() <= R[j]->getTotalPrice()) {
-                arr[k] = L[i]; i++;
-            } else {
-                arr[k] = R[j]; j++;
-            }
-            k++;
-        }
+    // The same reports as hand-written loops over the object graph
+    start = chrono::steady_clock::now();
+    map<tuple<string, string, int>, double> loopRevenue;
+    for (const auto& b : system.getBookings()) {
+        if (!b->isConfirmed()) continue;
+        const Flight& f = *b->getFlight();
+        loopRevenue[make_tuple(f.getDepartureCity(), f.getArrivalCity(), int(b->getSeatClass()))] += b->getTotalPrice();
+    }
+    array<double, 24> loopSold{}, loopSeats{};
+    for (const auto& f : system.getFlights()) {
+        int hour = (f->getDepartureMinutes() % MINUTES_PER_DAY) / 60;
+        loopSold[hour] += f->getTotalSeats() - f->getAvailableSeats();
+        loopSeats[hour] += f->getTotalSeats();
+    }
+    double loopMs = millis(start);
 
-        while (i < n1) { arr[k] = L[i]; i++; k++; }
-        while (j < n2) { arr[k] = R[j]; j++; k++; }
+    double engineTotal = 0, loopTotal = 0;
+    for (size_t g = 0; g < revenue.size(); g++) engineTotal += revenue.sum[g];
+    for (const auto& entry : loopRevenue) loopTotal += entry.second;
+
+    cout << system.getBookings().size() << " bookings, " << p.routes.size() << " routes, "
+         << engine.getThreads() << " thread(s)" << endl;
+    cout << "projection " << buildMs << " ms, engine queries " << engineMs << " ms, object-graph loops "
+         << loopMs << " ms" << endl;
+    cout << fixed << setprecision(2) << "confirmed revenue " << engineTotal << " (loops: " << loopTotal
+         << "), average fare " << avgFare << endl;
+
+    size_t best = 0;
+    for (size_t g = 1; g < revenue.size(); g++) {
+        if (revenue.sum[g] > revenue.sum[best]) best = g;
+    }
+    static const char* classNames[] = {"Economy", "Business", "First"};
+    cout << "top route/class: " << p.routeName(uint32_t(best / 3)) << " " << classNames[best % 3] << " "
+         << revenue.sum[best] << " over " << revenue.count[best] << " bookings" << endl;
+    cout << "load factor by departure hour:";
+    for (int h = 0; h < 24; h++) {
+        cout << " " << h << ":" << setprecision(0) << (seats.sum[h] ? 100 * sold.sum[h] / seats.sum[h] : 0) << "%";
     }
+    cout << endl;
+    return fabs(engineTotal - loopTotal) <= 0.01 + loopTotal * 1e-9 ? 0 : 1;
+}
 
-    // ============================================================================
-    // DISPLAY METHODS
-    // ============================================================================
+#ifdef __cpp_impl_coroutine
+// Usage: flightbooking_system workflow [bookings] [threads] [minLatencyMs] [maxLatencyMs] [declinePct]
+// Starts every booking workflow at once against the stand-in payment service
+// and reports throughput, peak in-flight workflows and seat accounting.
+int runWorkflowDemo(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000;
+    unsigned threads = argc > 3 ? atoi(argv[3]) : 2;
+    PaymentService::Config payConfig;
+    if (argc > 4) payConfig.minLatency = chrono::microseconds(llround(atof(argv[4]) * 1000));
+    if (argc > 5) payConfig.maxLatency = chrono::microseconds(llround(atof(argv[5]) * 1000));
+    if (argc > 6) payConfig.declineRate = atof(argv[6]) / 100.0;
 
-    void displayAllFlights() const {
-        cout << "Available Flights:" << endl;
-        for (const auto& flight : flights) {
-            flight->displayInfo();
-            cout << "Base Price: $" << flight->getBasePrice() << endl << endl;
-        }
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+    mt19937_64& rng = generator.random();
+    vector<string> flightNumbers;
+    for (const auto& f : system.getFlights()) flightNumbers.push_back(f->getFlightNumber());
+
+    CoroutineExecutor executor(threads);
+    PaymentService payments(executor, payConfig);
+    BookingWorkflow workflow(system, executor, payments);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        workflow.start(people[rng() % people.size()], flightNumbers[rng() % flightNumbers.size()],
+                       static_cast<SeatClass>(rng() % 3));
     }
+    workflow.waitIdle();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
 
-    void displayAllBookings() const {
-        cout << "All Bookings:" << endl;
-        for (const auto& booking : bookings) {
-            booking->displayBooking();
-            cout << "------------------------" << endl;
-        }
+    auto stats = workflow.getStats();
+    // Every confirmed booking holds exactly one seat; declined and sold-out ones hold none
+    uint64_t seatsTaken = workflow.withSystem([](FlightBookingSystem& sys) {
+        uint64_t taken = 0;
+        for (const auto& f : sys.getFlights()) taken += f->getTotalSeats() - f->getAvailableSeats();
+        return taken;
+    });
+    uint64_t confirmed = stats.outcomes[static_cast<size_t>(BookingWorkflow::Outcome::Confirmed)];
+
+    cout << count << " workflows on " << executor.threadCount() << " thread(s), payment latency "
+         << payConfig.minLatency.count() / 1000.0 << "-" << payConfig.maxLatency.count() / 1000.0 << " ms" << endl;
+    cout << "elapsed " << seconds << " s, " << uint64_t(count / seconds) << " workflows/s, peak in flight "
+         << stats.peakInFlight << endl;
+    for (size_t o = 0; o < stats.outcomes.size(); o++) {
+        cout << "  " << BookingWorkflow::outcomeName(static_cast<BookingWorkflow::Outcome>(o)) << ": "
+             << stats.outcomes[o] << endl;
     }
+    cout << "seats taken " << seatsTaken << " == confirmed " << confirmed << endl;
+    return seatsTaken == confirmed ? 0 : 1;
+}
+#endif
 
-    double getTotalRevenue() const {
-        double total = 0.0;
-        for (const auto& booking : bookings) {
-            if (booking->isConfirmed()) {
-                total += booking->getTotalPrice();
-            }
-        }
-        return total;
+// Usage: flightbooking_system seatindex [bookings] [queries]
+// Confirms bookings with seat selection, then answers fleet-wide seat
+// attribute queries from the bitmaps and checks them against seat-map walks.
+int runSeatIndexDemo(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 300000;
+    size_t queries = argc > 3 ? strtoull(argv[3], nullptr, 10) : 2000;
+
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    auto people = generator.makePassengers();
+    mt19937_64& rng = generator.random();
+    const auto& flights = system.getFlights();
+
+    auto start = chrono::steady_clock::now();
+    size_t seated = 0;
+    for (size_t i = 0; i < count; i++) {
+        auto booking = system.createBooking(people[rng() % people.size()],
+                                            flights[rng() % flights.size()]->getFlightNumber(),
+                                            static_cast<SeatClass>(rng() % 3 == 0 ? rng() % 3 : 0));
+        if (!booking || system.confirmOrWaitlist(booking->getBookingId()) != BookingStatus::Confirmed) continue;
+        seated += system.assignSeat(booking->getBookingId(), static_cast<SeatPreference>(rng() % 3)) >= 0;
+        if (rng() % 10 == 0) system.cancelBooking(booking->getBookingId());
     }
+    double claimMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
 
-    const vector<shared_ptr<Flight>>& getFlights() const { return flights; }
-    const vector<shared_ptr<Booking>>& getBookings() const { return bookings; }
-};
+    const FleetSeatIndex& index = system.getSeatIndex();
+    vector<string> origins;
+    for (const auto& f : flights) origins.push_back(f->getDepartureCity());
 
-// ============================================================================
-// ADVANCED ALGORITHMS
-// ============================================================================
+    using Attr = FleetSeatIndex::Attribute;
+    LatencyHistogram latency;
+    size_t matches = 0, mismatches = 0;
+    double walkMs = 0;
+    for (size_t q = 0; q < queries; q++) {
+        string origin = origins[rng() % origins.size()];
+        TimeMinutes day = static_cast<TimeMinutes>(rng() % config.days);
+        SeatClass seatClass = static_cast<SeatClass>(rng() % 3);
+        Attr attribute = static_cast<Attr>(rng() % FleetSeatIndex::ATTRIBUTE_COUNT);
 
-// Dijkstra's Algorithm for route optimization
-class RouteOptimizer {
-private:
-    unordered_map<string, vector<pair<string, double>>> graph; // city -> [(destination, price)]
+        auto t0 = chrono::steady_clock::now();
+        auto found = system.findFlightsWithSeats(origin, day, seatClass, attribute);
+        latency.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
+        matches += found.size();
 
-public:
-    void addFlightRoute(const string& from, const string& to, double price) {
-        graph[from].push_back({to, price});
-        graph[to].push_back({from, price}); // Assuming bidirectional
+        // Reference answer: walk every candidate flight's seat map
+        t0 = chrono::steady_clock::now();
+        size_t expected = 0;
+        for (const auto& f : flights) {
+            if (f->getDepartureCity() == origin && dayOf(f->getDepartureMinutes()) == day &&
+                f->getAvailableSeats() > 0 && index.seatsForSale(f->getInventorySlot(), seatClass) > 0 &&
+                index.countByWalking(f->getInventorySlot(), seatClass, attribute) > 0) {
+                expected++;
+            }
+        }
+        walkMs += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        mismatches += expected != found.size();
     }
 
-    double findCheapestRoute(const string& start, const string& end) {
-        unordered_map<string, double> distances;
-        priority_queue<pair<double, string>, vector<pair<double, string>>, greater<pair<double, string>>> pq;
+    cout << count << " bookings, " << seated << " seats claimed in " << claimMs << " ms" << endl;
+    cout << queries << " queries: " << matches << " matching flights, p50 " << latency.percentile(0.5)
+         << " ns, p99 " << latency.percentile(0.99) << " ns; seat-map walk " << walkMs * 1e6 / max<size_t>(queries, 1)
+         << " ns per query" << endl;
+    cout << "index memory " << index.memoryBytes() << " bytes, mismatches " << mismatches << endl;
 
-        for (auto& city : graph) {
-            distances[city.first] = numeric_limits<double>::infinity();
+    auto economyWindowPairs = index.flightsWith(SeatClass::Economy, Attr::WindowPair);
+    auto roomyBusiness = index.flightsWithFreeSeats(SeatClass::Business, 10);
+    cout << "economy window pair OR 10+ business seats: " << (economyWindowPairs | roomyBusiness).cardinality()
+         << " flights, AND: " << (economyWindowPairs & roomyBusiness).cardinality() << endl;
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Usage: flightbooking_system itinerary [queries] [k] [soldOutPct]
+// Sells out a share of flights, then searches random city pairs and checks
+// every returned itinerary for seats, connections and ordering.
+int runItineraryDemo(int argc, char* argv[]) {
+    size_t queries = argc > 2 ? strtoull(argv[2], nullptr, 10) : 2000;
+    size_t k = argc > 3 ? strtoull(argv[3], nullptr, 10) : 5;
+    int soldOutPct = argc > 4 ? atoi(argv[4]) : 30;
+
+    WorkloadConfig config;
+    FlightBookingSystem system;
+    WorkloadGenerator generator(config);
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    mt19937_64& rng = generator.random();
+    RouteOptimizer optimizer;
+    size_t soldOut = 0;
+    for (const auto& f : system.getFlights()) {
+        optimizer.addFlightRoute(f->getDepartureCity(), f->getArrivalCity(), f->getFare());
+        if (int(rng() % 100) < soldOutPct) {
+            f->bookSeats(f->getAvailableSeats());
+            soldOut++;
         }
-        distances[start] = 0;
-        pq.push({0, start});
+    }
+    vector<string> cities;
+    for (const auto& f : system.getFlights()) cities.push_back(f->getDepartureCity());
 
-        while (!pq.empty()) {
-            auto [cost, current] = pq.top(); pq.pop();
+    ItinerarySearch search(system.getQueryEngine());
+    LatencyHistogram latency;
+    size_t found = 0, truncated = 0, invalid = 0, labels = 0;
+    for (size_t i = 0; i < queries; i++) {
+        ItineraryQuery q;
+        q.origin = cities[rng() % cities.size()];
+        q.destination = cities[rng() % cities.size()];
+        q.departAfter = static_cast<TimeMinutes>(rng() % config.days) * MINUTES_PER_DAY;
+        q.departBefore = q.departAfter + MINUTES_PER_DAY;
+        q.seats = 1 + static_cast<int>(rng() % 4);
+        q.k = k;
 
-            if (cost > distances[current]) continue;
+        auto start = chrono::steady_clock::now();
+        auto result = search.search(q);
+        latency.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+        found += result.itineraries.size();
+        truncated += result.truncated;
+        labels = max(labels, result.labelsUsed);
 
-            for (auto& [neighbor, price] : graph[current]) {
-                double newCost = cost + price;
-                if (newCost < distances[neighbor]) {
-                    distances[neighbor] = newCost;
-                    pq.push({newCost, neighbor});
+        double previous = 0;
+        for (const auto& it : result.itineraries) {
+            bool ok = it.price >= previous && it.legs.front()->getDepartureCity() == q.origin &&
+                      it.legs.back()->getArrivalCity() == q.destination && it.arrival - it.departure <= q.maxTripMinutes;
+            for (size_t l = 0; l < it.legs.size(); l++) {
+                ok = ok && it.legs[l]->getAvailableSeats() >= q.seats;
+                if (l > 0) {
+                    ok = ok && it.legs[l]->getDepartureCity() == it.legs[l - 1]->getArrivalCity() &&
+                         it.legs[l]->getDepartureMinutes() >= it.legs[l - 1]->getArrivalMinutes() + q.minConnection;
                 }
             }
+            invalid += !ok;
+            previous = it.price;
         }
-
-        return distances[end];
     }
-};
 
-// Greedy algorithm for seat assignment
-class SeatAssigner {
-private:
-    vector<vector<bool>> seatMap; // true = occupied
+    cout << system.getFlights().size() << " flights, " << soldOut << " sold out; " << queries << " queries, k = " << k
+         << endl;
+    cout << "itineraries " << found << ", invalid " << invalid << ", truncated queries " << truncated
+         << ", peak labels " << labels << ", scratch " << search.memoryBytes() << " bytes" << endl;
+    cout << "latency p50 " << latency.percentile(0.5) << " ns, p99 " << latency.percentile(0.99) << " ns, max "
+         << latency.maxNanos() << " ns" << endl;
 
-public:
-    SeatAssigner(int rows, int cols) : seatMap(rows, vector<bool>(cols, false)) {}
+    ItineraryQuery sample;
+    sample.origin = "Patna";
+    sample.destination = "London";
+    sample.departAfter = MINUTES_PER_DAY;
+    sample.departBefore = 2 * MINUTES_PER_DAY;
+    sample.k = 3;
+    cout << "Patna -> London on day 1 (abstract price graph says " << optimizer.findCheapestRoute("Patna", "London")
+         << "):" << endl;
+    for (const auto& it : search.search(sample).itineraries) {
+        cout << "  $" << it.price << " " << formatTime(it.departure) << " -> " << formatTime(it.arrival) << ":";
+        for (const Flight* leg : it.legs) {
+            cout << " " << leg->getFlightNumber() << " " << leg->getDepartureCity() << "-" << leg->getArrivalCity();
+        }
+        cout << endl;
+    }
+    return invalid == 0 ? 0 : 1;
+}
 
-    pair<int, int> assignBestSeat() {
-        // Priority: aisle seats, then window seats, then middle
-        vector<pair<int, int>> preferences;
+// Usage: flightbooking_system farecalendar [flights] [updates] [threads]
+// Builds the fare calendar over a year-long schedule, applies random seat
+// and fare changes, and checks every cell and a price-range search
+// against a full rescan. Exits nonzero on any mismatch.
+int runFareCalendarDemo(int argc, char* argv[]) {
+    WorkloadConfig config;
+    config.flights = argc > 2 ? strtoull(argv[2], nullptr, 10) : 50000;
+    size_t updates = argc > 3 ? strtoull(argv[3], nullptr, 10) : 200000;
+    unsigned threads = argc > 4 ? static_cast<unsigned>(atoi(argv[4])) : 0;
+    config.days = 365;
 
-        int cols = seatMap[0].size();
-        for (int row = 0; row < seatMap.size(); row++) {
-            // Aisle seats (assuming 3-3-3 configuration: seats 0,2,3,5 are aisle)
-            if (!seatMap[row][0]) preferences.push_back({row, 0}); // Aisle
-            if (!seatMap[row][2]) preferences.push_back({row, 2}); // Aisle
-            if (!seatMap[row][3]) preferences.push_back({row, 3}); // Aisle
-            if (!seatMap[row][5]) preferences.push_back({row, 5}); // Aisle
+    WorkloadGenerator generator(config);
+    mt19937_64& rng = generator.random();
+    FlightBookingSystem system;
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    const auto& flights = system.getFlights();
 
-            // Window seats
-            if (!seatMap[row][cols-1]) preferences.push_back({row, cols-1}); // Window
-        }
+    auto start = chrono::steady_clock::now();
+    system.buildFareCalendar(0, config.days, threads);
+    double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    const FareCalendar& calendar = system.getFareCalendar();
 
-        if (!preferences.empty()) {
-            auto seat = preferences[0];
-            seatMap[seat.first][seat.second] = true;
-            return seat;
+    // Every cell of the calendar, recomputed from scratch
+    auto mismatches = [&]() {
+        map<tuple<string, string, TimeMinutes>, double> expected;
+        for (const auto& f : flights) {
+            auto key = make_tuple(f->getDepartureCity(), f->getArrivalCity(), dayOf(f->getDepartureMinutes()));
+            double& cell = expected.emplace(key, FareCalendar::NO_FARE).first->second;
+            if (f->getAvailableSeats() > 0) cell = min(cell, f->getFare());
+        }
+        map<pair<string, string>, vector<double>> routes; // route -> expected row
+        for (const auto& [key, fare] : expected) {
+            auto& row = routes.try_emplace({get<0>(key), get<1>(key)}, calendar.windowDays(), FareCalendar::NO_FARE)
+                            .first->second;
+            if (get<2>(key) >= 0 && get<2>(key) < calendar.windowDays()) row[get<2>(key)] = fare;
         }
+        size_t bad = 0;
+        for (const auto& [route, want] : routes) {
+            const double* row = calendar.routeRow(route.first, route.second);
+            if (!row) bad += want.size();
+            for (size_t day = 0; row && day < want.size(); day++) bad += row[day] != want[day];
+        }
+        return bad;
+    };
+    size_t badAfterBuild = mismatches();
 
-        // Fallback: first available seat
-        for (int row = 0; row < seatMap.size(); row++) {
-            for (int col = 0; col < seatMap[row].size(); col++) {
-                if (!seatMap[row][col]) {
-                    seatMap[row][col] = true;
-                    return {row, col};
-                }
+    // Price-range searches must follow fare changes
+    auto priceRangeMatches = [&](double low, double high) {
+        size_t expected = 0;
+        for (const auto& f : flights) expected += f->getFare() >= low && f->getFare() <= high;
+        return system.findFlightsByPriceRange(low, high).size() == expected;
+    };
+    bool rangeOk = priceRangeMatches(4000, 6000);
+
+    LatencyHistogram seatLatency, fareLatency;
+    size_t soldOut = 0;
+    for (size_t i = 0; i < updates; i++) {
+        Flight& flight = *flights[rng() % flights.size()];
+        auto t0 = chrono::steady_clock::now();
+        switch (rng() % 3) {
+            case 0: // a group booking; often sells the flight out
+                flight.bookSeats(1 + static_cast<int>(rng() % 200));
+                soldOut += flight.getAvailableSeats() == 0;
+                break;
+            case 1:
+                flight.releaseSeat();
+                break;
+            default: {
+                double base = flight.getBasePrice();
+                auto t1 = chrono::steady_clock::now();
+                flight.setFare(base * (0.5 + double(rng() % 1001) / 1000.0));
+                fareLatency.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t1).count());
+                continue;
             }
         }
-
-        return {-1, -1}; // No seats available
+        seatLatency.record(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - t0).count());
     }
+    rangeOk = rangeOk && priceRangeMatches(4000, 6000);
+    size_t badAfterUpdates = mismatches();
 
-    void displaySeatMap() const {
-        cout << "Seat Map (O = occupied, . = available):" << endl;
-        for (int row = 0; row < seatMap.size(); row++) {
-            for (int col = 0; col < seatMap[row].size(); col++) {
-                cout << (seatMap[row][col] ? "O" : ".") << " ";
+    // Calendar lookups against the per-cell scan they replace
+    const size_t lookups = 2000;
+    vector<tuple<string, string, TimeMinutes>> cells;
+    for (size_t i = 0; i < lookups; i++) {
+        const auto& f = flights[rng() % flights.size()];
+        cells.emplace_back(f->getDepartureCity(), f->getArrivalCity(), TimeMinutes(rng() % config.days));
+    }
+    vector<double> scanned, looked;
+    scanned.reserve(lookups);
+    looked.reserve(lookups);
+    start = chrono::steady_clock::now();
+    for (const auto& [from, to, day] : cells) {
+        double best = FareCalendar::NO_FARE;
+        for (const auto& f : flights) {
+            if (f->getDepartureCity() == from && f->getArrivalCity() == to &&
+                dayOf(f->getDepartureMinutes()) == day && f->getAvailableSeats() > 0) {
+                best = min(best, f->getFare());
             }
-            cout << endl;
         }
+        scanned.push_back(best);
     }
-};
+    double scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+    start = chrono::steady_clock::now();
+    for (const auto& [from, to, day] : cells) looked.push_back(calendar.minFare(from, to, day));
+    double lookupNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
 
-// ============================================================================
-// DESIGN PATTERNS
-// ============================================================================
+    cout << "{\n  \"flights\": " << flights.size() << ", \"routes\": " << calendar.routeCount()
+         << ", \"days\": " << calendar.windowDays() << ", \"memory_bytes\": " << calendar.memoryBytes()
+         << ",\n  \"build_ms\": " << buildSeconds * 1000 << ", \"threads\": "
+         << (threads ? threads : max(1u, thread::hardware_concurrency()))
+         << ",\n  \"seat_update\": {\"count\": " << seatLatency.count() << ", \"mean_ns\": " << uint64_t(seatLatency.mean())
+         << ", \"p99_ns\": " << seatLatency.percentile(0.99) << ", \"sold_out\": " << soldOut << "}"
+         << ",\n  \"fare_update\": {\"count\": " << fareLatency.count() << ", \"mean_ns\": " << uint64_t(fareLatency.mean())
+         << ", \"p99_ns\": " << fareLatency.percentile(0.99) << "}"
+         << ",\n  \"cell_lookup_ns\": " << lookupNs << ", \"cell_scan_ns\": " << scanNs
+         << ",\n  \"mismatches_after_build\": " << badAfterBuild << ", \"mismatches_after_updates\": " << badAfterUpdates
+         << ", \"price_range_ok\": " << (rangeOk ? "true" : "false") << "\n}" << endl;
+    return badAfterBuild == 0 && badAfterUpdates == 0 && rangeOk && scanned == looked ? 0 : 1;
+}
 
-// Factory Pattern for creating different types of flights
-class FlightFactory {
-public:
-    static shared_ptr<Flight> createFlight(string type, string fn, string dep, string arr, string depTime, string arrTime, int seats) {
-        if (type == "Domestic") {
-            return make_shared<DomesticFlight>(fn, dep, arr, depTime, arrTime, seats);
-        } else if (type == "International") {
-            return make_shared<InternationalFlight>(fn, dep, arr, depTime, arrTime, seats);
-        }
-        return nullptr;
-    }
-};
+// Usage: flightbooking_system alloctest [bookings]
+// Counts heap allocations over steady-state createBooking + confirmOrWaitlist
+// calls (passengers on file, storage reserved) and exits nonzero if there
+// are any. Needs a build with -DFBS_ALLOC_TEST to count; not part of any
+// automated build, run it by hand after touching the booking path. Every
+// booking must find a free seat, so the count is capped at the fleet's seats.
+int runAllocTest(int argc, char* argv[]) {
+    size_t count = argc > 2 ? strtoull(argv[2], nullptr, 10) : 100000;
+    size_t warmup = 1000;
 
-// Strategy Pattern for different pricing strategies
-class PricingStrategy {
-public:
-    virtual double calculatePrice(double basePrice, SeatClass seatClass) = 0;
-    virtual ~PricingStrategy() = default;
-};
+    WorkloadConfig config;
+    WorkloadGenerator generator(config);
+    mt19937_64& rng = generator.random();
+    FlightBookingSystem system;
+    for (const auto& f : generator.makeSchedule()) system.addFlight(f);
+    size_t capacity = 0;
+    for (const auto& f : system.getFlights()) capacity += f->getAvailableSeats();
+    warmup = min(warmup, capacity / 2);
+    if (warmup + count > capacity) {
+        count = capacity - warmup;
+        cerr << "fleet has " << capacity << " seats; testing " << count << " bookings" << endl;
+    }
+    vector<shared_ptr<Passenger>> people;
+    for (const auto& p : generator.makePassengers()) {
+        people.push_back(system.registerPassenger(p->getName(), p->getPassport(), p->getContact(), p->getEmail()));
+    }
+    system.reserveBookings(warmup + count);
+    const auto& flights = system.getFlights();
 
-class StandardPricing : public PricingStrategy {
-public:
-    double calculatePrice(double basePrice, SeatClass seatClass) override {
-        double multiplier = 1.0;
-        switch (seatClass) {
-            case SeatClass::Business: multiplier = 2.5; break;
-            case SeatClass::First: multiplier = 4.0; break;
+    size_t confirmed = 0;
+    auto book = [&](size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            const Flight* flight = flights[rng() % flights.size()].get();
+            while (flight->getAvailableSeats() == 0) flight = flights[rng() % flights.size()].get();
+            auto booking = system.createBooking(people[rng() % people.size()], flight->getFlightNumber(),
+                                                static_cast<SeatClass>(rng() % 3));
+            if (booking && system.confirmOrWaitlist(booking->getBookingId()) == BookingStatus::Confirmed) confirmed++;
         }
-        return basePrice * multiplier;
+    };
+    book(warmup); // first-use costs: metrics slot, snapshot versions
+
+    uint64_t before = AllocationCounter::count();
+    auto start = chrono::steady_clock::now();
+    book(count);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t allocations = AllocationCounter::count() - before;
+
+    cout << "{\"bookings\": " << count << ", \"confirmed\": " << confirmed
+         << ", \"ns_per_create_confirm\": " << uint64_t(seconds * 1e9 / max<size_t>(count, 1))
+         << ", \"allocations\": ";
+    if (!AllocationCounter::ENABLED) {
+        cout << "null}" << endl;
+        cerr << "allocation counting needs a build with -DFBS_ALLOC_TEST" << endl;
+        return 2;
     }
-};
+    cout << allocations << "}" << endl;
+    if (confirmed != warmup + count || allocations != 0) {
+        cerr << "FAIL: create-and-confirm path allocated " << allocations << " times" << endl;
+        return 1;
+    }
+    return 0;
+}
 
-class DiscountPricing : public PricingStrategy {
-public:
-    double calculatePrice(double basePrice, SeatClass seatClass) override {
-        double multiplier = 0.8; // 20% discount
-        switch (seatClass) {
-            case SeatClass::Business: multiplier = 2.0; break; // 2.0 * 0.8 = 1.6x base
-            case SeatClass::First: multiplier = 3.2; break;    // 4.0 * 0.8 = 3.2x base
+// Usage: flightbooking_system trace record <path> [flights] [passengers] [operations]
+//        flightbooking_system trace replay <path> [paced]
+// record runs the bench workload with the recorder attached; replay
+// re-executes the trace and prints per-operation timing as JSON.
+int runTrace(int argc, char* argv[]) {
+    string action = argc > 2 ? argv[2] : "";
+    string path = argc > 3 ? argv[3] : "/tmp/fbs.trace";
+    if (action == "record") {
+        WorkloadConfig config;
+        if (argc > 4) config.flights = strtoull(argv[4], nullptr, 10);
+        if (argc > 5) config.passengers = strtoull(argv[5], nullptr, 10);
+        if (argc > 6) config.operations = strtoull(argv[6], nullptr, 10);
+        auto recorder = TraceRecorder::open(path);
+        if (!recorder) {
+            perror(path.c_str());
+            return 1;
         }
-        return basePrice * multiplier;
+        BookingBenchmark benchmark(config);
+        benchmark.setTracer(recorder.get());
+        benchmark.run();
+        recorder->flush();
+        cerr << "recorded " << recorder->recordCount() << " calls, " << recorder->bytes() << " bytes ("
+             << double(recorder->bytes()) / max<uint64_t>(recorder->recordCount(), 1) << " bytes/call) to " << path
+             << endl;
+        benchmark.writeJson(cout);
+        return 0;
     }
-};
+    if (action == "replay") {
+        TraceReplayer replayer(path);
+        if (!replayer.run(argc > 4 && string(argv[4]) == "paced")) {
+            cerr << "cannot replay " << path << endl;
+            return 1;
+        }
+        replayer.writeJson(cout);
+        return 0;
+    }
+    cerr << "Usage: trace record <path> [flights] [passengers] [operations] | trace replay <path> [paced]" << endl;
+    return 1;
+}
 
-// ============================================================================
-// MAIN FUNCTION - DEMONSTRATION
-// ============================================================================
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if (mode == "simulate") return runOverbookingSimulation(argc, argv);
+        if (mode == "bench") return runBenchmark(argc, argv);
+        if (mode == "service") return runServiceDemo(argc, argv);
+        if (mode == "snapbench") return runSnapshotBenchmark(argc, argv);
+        if (mode == "sortbench") return runSortBenchmark(argc, argv);
+        if (mode == "export") return runExportBenchmark(argc, argv);
+        if (mode == "archive") return runArchiveDemo(argc, argv);
+        if (mode == "analytics") return runAnalyticsDemo(argc, argv);
+        if (mode == "seatindex") return runSeatIndexDemo(argc, argv);
+        if (mode == "itinerary") return runItineraryDemo(argc, argv);
+        if (mode == "trace") return runTrace(argc, argv);
+        if (mode == "farecalendar") return runFareCalendarDemo(argc, argv);
+        if (mode == "alloctest") return runAllocTest(argc, argv);
+#ifdef __cpp_impl_coroutine
+        if (mode == "workflow") return runWorkflowDemo(argc, argv);
+#endif
+#ifdef __linux__
+        if (mode == "server") return runServer(argc, argv);
+        if (mode == "loadclient") return runLoadClient(argc, argv);
+        if (mode == "shardbench") return runShardBenchmark(argc, argv);
+        if (mode == "shmdemo") return runSharedInventoryDemo(argc, argv);
+#endif
+        cerr << "Unknown mode: " << mode << endl;
+        cerr << "Modes: simulate, bench, service, snapbench, sortbench, export, archive, analytics, seatindex, itinerary, farecalendar, trace, alloctest, workflow, server, loadclient, shardbench, shmdemo" << endl;
+        return 1;
+    }
 
-int main() {
     cout << "=== FLIGHT BOOKING SYSTEM DEMONSTRATION ===" << endl << endl;
 
     FlightBookingSystem system;
@@ -503,9 +7773,9 @@ int main() {
     system.addFlight(domesticFlight);
     system.addFlight(internationalFlight);
 
-    // Create passengers
-    auto passenger1 = make_shared<Passenger>("John Doe", "P123456", "+91-9876543210", "john@example.com");
-    auto passenger2 = make_shared<Passenger>("Jane Smith", "P789012", "+1-555-0123", "jane@example.com");
+    // Create passengers (the registry deduplicates by passport)
+    auto passenger1 = system.registerPassenger("John Doe", "P123456", "+91-9876543210", "john@example.com");
+    auto passenger2 = system.registerPassenger("Jane Smith", "P789012", "+1-555-0123", "jane@example.com");
 
     // Create bookings
     auto booking1 = system.createBooking(passenger1, "AI101", SeatClass::Economy);
@@ -521,6 +7791,37 @@ int main() {
 
     cout << "Total Revenue: $" << system.getTotalRevenue() << endl << endl;
 
+    // Lookup by booking ID through the hash index
+    if (booking2) {
+        BookingId id = booking2->getBookingId();
+        auto found = system.findBooking(id);
+        cout << "Lookup " << formatBookingId(id) << " (shard " << BookingIdGenerator::shardOf(id)
+             << ", seq " << BookingIdGenerator::sequenceOf(id) << "): "
+             << (found ? found->getPassenger()->getName() : "not found") << endl << endl;
+    }
+
+    // Repeat traveller: same passport maps to the same passenger record
+    auto repeat = system.registerPassenger("John Doe", "P123456", "+91-9876543210", "john@example.com");
+    system.createBooking(repeat, "AI301", SeatClass::First);
+    cout << "Passenger P123456 is deduplicated: " << (repeat == passenger1 ? "yes" : "no")
+         << ", bookings on file: " << system.getBookingsForPassenger("P123456").size() << endl << endl;
+
+    // Cancellation and waitlist on a one-seat flight
+    auto charterFlight = FlightFactory::createFlight("Domestic", "AI501", "Delhi", "Goa", "07:00", "09:30", 1);
+    system.addFlight(charterFlight);
+    auto first = system.createBooking(passenger1, "AI501", SeatClass::Economy);
+    auto second = system.createBooking(passenger2, "AI501", SeatClass::Economy);
+    auto third = system.createBooking(system.registerPassenger("Ravi Kumar", "P345678", "+91-9123456780", "ravi@example.com"),
+                                      "AI501", SeatClass::Business);
+    system.confirmOrWaitlist(first->getBookingId());
+    system.confirmOrWaitlist(second->getBookingId());
+    system.confirmOrWaitlist(third->getBookingId());
+    cout << "AI501 waitlist after 3 requests for 1 seat: " << system.getWaitlistSize(*charterFlight) << endl;
+    system.cancelBooking(first->getBookingId());
+    cout << "After cancelling " << formatBookingId(first->getBookingId()) << ", seat goes to: "
+         << (third->isConfirmed() ? third->getPassenger()->getName() : second->getPassenger()->getName())
+         << " (Business outranks the earlier Economy request)" << endl << endl;
+
     // ============================================================================
     // DEMONSTRATE SEARCH ALGORITHMS
     // ============================================================================
@@ -541,9 +7842,37 @@ int main() {
     auto cheapFlight = system.findCheapestFlight(10000);
     if (cheapFlight) {
         cout << "Cheapest flight under $10000: " << cheapFlight->getFlightNumber()
-             << " ($" << cheapFlight->getBasePrice() << ")" << endl;
+             << " ($" << cheapFlight->getFare() << ")" << endl;
+    }
+
+    // Combined query streamed through a cursor
+    FlightQuery q;
+    q.origin = "Delhi";
+    q.departAfter = parseTime("08:00");
+    q.departBefore = parseTime("23:00");
+    q.maxPrice = 30000;
+    q.minFreeSeats = 1;
+    auto cursor = system.query(q);
+    const Flight* page[8];
+    cout << "Flights from Delhi 08:00-23:00 under $30000:";
+    while (size_t n = cursor.nextPage(page, 8)) {
+        for (size_t i = 0; i < n; i++) cout << " " << page[i]->getFlightNumber();
+    }
+    cout << endl;
+
+    // Search-box autocomplete: prefixes, other words of a name, and typos
+    for (string input : {"de", "york", "AI3", "Mumbia"}) {
+        cout << "Autocomplete \"" << input << "\":";
+        for (const auto& c : system.autocomplete(input, 3)) cout << " " << c.text;
+        cout << endl;
     }
 
+    // Departure-window range scan on the ordered index
+    auto morning = system.findFlightsDepartingBetween("Delhi", parseTime("06:00"), parseTime("12:00"));
+    cout << "Flights from Delhi departing 06:00-12:00:";
+    for (const auto& flight : morning) cout << " " << flight->getFlightNumber() << " (" << flight->getDepartureTime() << ")";
+    cout << endl;
+
     cout << endl;
 
     // ============================================================================
@@ -557,7 +7886,7 @@ int main() {
     system.sortFlightsByPrice(flightList);
     cout << "Flights sorted by price:" << endl;
     for (const auto& flight : flightList) {
-        cout << flight->getFlightNumber() << ": $" << flight->getBasePrice() << endl;
+        cout << flight->getFlightNumber() << ": $" << flight->getFare() << endl;
     }
 
     // Sort bookings by price
@@ -600,6 +7929,12 @@ int main() {
     cout << "\nFinal seat map:" << endl;
     seatAssigner.displaySeatMap();
 
+    // Monte Carlo overbooking simulation over the current schedule
+    OverbookingConfig simConfig;
+    simConfig.trialsPerFlight = 100000;
+    cout << "\nOverbooking 5% with 92% show rate (" << simConfig.trialsPerFlight << " trials per flight):" << endl;
+    OverbookingSimulator::printReport(OverbookingSimulator(simConfig).run(system.getFlights()));
+
     cout << endl;
 
     // ============================================================================
@@ -617,6 +7952,12 @@ int main() {
     cout << "Standard Business class: $" << standardPricing.calculatePrice(basePrice, SeatClass::Business) << endl;
     cout << "Discount Business class: $" << discountPricing.calculatePrice(basePrice, SeatClass::Business) << endl;
 
+    cout << endl << "=== OPERATION METRICS ===" << endl;
+    OperationMetrics::dump(cout);
+    QueryCacheStats cacheStats = system.getQueryCacheStats();
+    cout << "query cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+         << cacheStats.invalidations << " invalidations" << endl;
+
     cout << endl << "=== DEMONSTRATION COMPLETE ===" << endl;
 
     return 0;